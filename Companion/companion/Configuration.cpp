@@ -22,50 +22,75 @@ Companion::Configuration::Configuration()
 {
     this->source = nullptr;
     this->processing = nullptr;
-    this->worker = nullptr;
+    this->framePool = nullptr;
+    this->handle = nullptr;
     this->skipFrame = 0;
-    this->threadsRunning = false;
+    this->latencyBudget = 0;
     this->imageBuffer = 5;
+    this->consumerThreads = 1;
+    this->waitPolicy = Thread::WaitPolicy::BLOCKING;
+    this->backpressure = Thread::BackpressurePolicy::BLOCK;
 }
 
 void Companion::Configuration::Run()
 {
-    if (this->threadsRunning)
+    PTR_STREAM_HANDLE handle;
+
     {
-        // Stop active worker if running
+        std::lock_guard<std::mutex> lk(this->handleMx);
+        handle = this->handle;
+    }
+
+    if (handle != nullptr && handle->IsRunning())
+    {
+        // Stop active execution if running
         this->Stop();
     }
     else
     {
-        // Create a new worker thread for execution only if no threads are active
-		this->worker = std::make_shared<STREAM_WORKER>(this->imageBuffer, this->colorFormat);
-
-        // Get all configuration data
-        // Throws Error if invalid settings are set.
-		PTR_STREAM stream = this->Source();
-        PTR_IMAGE_PROCESSING imageProcessing = this->Processing();
-        int skipFrame = this->SkipFrame();
-        std::function<ERROR_CALLBACK> errorCallback = this->ErrorCallback();
-        std::function<SUCCESS_CALLBACK> successCallback = this->ResultCallback();
-
-        // Run new worker class.
-        this->threadsRunning = true;
-        this->producer = std::thread(&Thread::StreamWorker::Produce, this->worker, stream, skipFrame, errorCallback);
-        this->consumer = std::thread(&Thread::StreamWorker::Consume, this->worker, imageProcessing, errorCallback, successCallback);
-        this->producer.join();
-        this->consumer.join();
-        this->threadsRunning = false;
+        this->Start()->Wait();
     }
 }
 
-void Companion::Configuration::Stop()
+PTR_STREAM_HANDLE Companion::Configuration::Start()
 {
-    if (this->threadsRunning && (this->source != nullptr) && !this->source->IsFinished())
+    std::lock_guard<std::mutex> lk(this->handleMx);
+
+    if (this->handle != nullptr && this->handle->IsRunning())
+    {
+        return this->handle;
+    }
+
+    // Get all configuration data
+    // Throws Error if invalid settings are set.
+    PTR_STREAM stream = this->Source();
+    PTR_IMAGE_PROCESSING imageProcessing = this->Processing();
+    int skipFrame = this->SkipFrame();
+    std::function<ERROR_CALLBACK> errorCallback = this->ErrorCallback();
+    std::function<SUCCESS_CALLBACK> successCallback = this->ResultCallback();
+
+    // Create a new worker for execution only if no threads are active
+    // Threads keep their own references, so the handle can be released at any time
+    this->handle = std::make_shared<STREAM_HANDLE>(this->CreateWorker(), stream, imageProcessing, skipFrame, this->consumerThreads, errorCallback, successCallback);
+    return this->handle;
+}
+
+PTR_STREAM_WORKER Companion::Configuration::CreateWorker() const
+{
+    PTR_STREAM_WORKER worker = std::make_shared<STREAM_WORKER>(this->imageBuffer, this->colorFormat, this->waitPolicy, this->backpressure);
+    worker->LatencyBudget(this->latencyBudget);
+    worker->FramePool(this->framePool);
+
+    return worker;
+}
+
+void Companion::Configuration::Stop(Thread::ShutdownMode mode)
+{
+    std::lock_guard<std::mutex> lk(this->handleMx);
+
+    if (this->handle != nullptr)
     {
-        // To stop running worker threads stop streams.
-        this->source->Finish();
-        this->source = nullptr;
-        this->worker = nullptr;
+        this->handle->Stop(mode);
     }
 }
 
@@ -83,6 +108,11 @@ PTR_STREAM Companion::Configuration::Source() const
 void Companion::Configuration::Source(PTR_STREAM source)
 {
     this->source = source;
+
+    if (this->source != nullptr && this->framePool != nullptr)
+    {
+        this->source->FramePool(this->framePool);
+    }
 }
 
 PTR_IMAGE_PROCESSING Companion::Configuration::Processing() const
@@ -117,6 +147,22 @@ void Companion::Configuration::SkipFrame(int skipFrame)
     this->skipFrame = skipFrame;
 }
 
+int Companion::Configuration::LatencyBudget() const
+{
+    return this->latencyBudget;
+}
+
+void Companion::Configuration::LatencyBudget(int latencyBudget)
+{
+
+    if (latencyBudget <= 0)
+    {
+        latencyBudget = 0;
+    }
+
+    this->latencyBudget = latencyBudget;
+}
+
 int Companion::Configuration::ImageBuffer() const
 {
     return this->imageBuffer;
@@ -133,6 +179,69 @@ void Companion::Configuration::ImageBuffer(int imageBuffer)
     this->imageBuffer = imageBuffer;
 }
 
+int Companion::Configuration::ConsumerThreads() const
+{
+    return this->consumerThreads;
+}
+
+void Companion::Configuration::ConsumerThreads(int consumerThreads)
+{
+
+    if (consumerThreads <= 0)
+    {
+        consumerThreads = 1;
+    }
+
+    this->consumerThreads = consumerThreads;
+}
+
+Companion::Thread::WaitPolicy Companion::Configuration::WaitPolicy() const
+{
+    return this->waitPolicy;
+}
+
+void Companion::Configuration::WaitPolicy(Thread::WaitPolicy waitPolicy)
+{
+    this->waitPolicy = waitPolicy;
+}
+
+Companion::Thread::BackpressurePolicy Companion::Configuration::Backpressure() const
+{
+    return this->backpressure;
+}
+
+void Companion::Configuration::Backpressure(Thread::BackpressurePolicy backpressure)
+{
+    this->backpressure = backpressure;
+}
+
+unsigned long Companion::Configuration::DroppedFrames() const
+{
+    std::lock_guard<std::mutex> lk(this->handleMx);
+
+    if (this->handle == nullptr)
+    {
+        return 0;
+    }
+
+    return this->handle->Statistics().droppedFrames;
+}
+
+PTR_FRAME_POOL Companion::Configuration::FramePool() const
+{
+    return this->framePool;
+}
+
+void Companion::Configuration::FramePool(PTR_FRAME_POOL framePool)
+{
+    this->framePool = framePool;
+
+    if (this->source != nullptr)
+    {
+        this->source->FramePool(this->framePool);
+    }
+}
+
 void Companion::Configuration::ResultCallback(std::function<SUCCESS_CALLBACK> callback, Companion::ColorFormat colorFormat)
 {
     this->callback = callback;
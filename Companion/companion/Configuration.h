@@ -20,8 +20,9 @@
 #define COMPANION_CONFIGURATION_H
 
 #include <functional>
-#include <thread>
+#include <mutex>
 #include <companion/thread/StreamWorker.h>
+#include <companion/thread/StreamHandle.h>
 #include <companion/input/Stream.h>
 #include <companion/processing/ImageProcessing.h>
 #include <companion/util/Definitions.h>
@@ -50,15 +51,32 @@ namespace Companion
 		virtual ~Configuration() = default;
 
 		/**
-		 * Execute companion configuration.
+		 * Execute companion configuration and block until the stream has finished or the execution was stopped.
+		 * If the configuration is already running the execution is stopped instead.
 		 * @throws error Companion::Error::Code error code if an invalid configuration is set.
 		 */
 		void Run();
 
 		/**
-		 * Stop current running stream worker if it's executes.
+		 * Start companion configuration asynchronously. If the configuration is already running the handle of the
+		 * running execution is returned.
+		 * @throws error Companion::Error::Code error code if an invalid configuration is set.
+		 * @return Handle to stop or to wait for the execution and to obtain its final frame statistics.
+		 */
+		PTR_STREAM_HANDLE Start();
+
+		/**
+		 * Create a new stream worker with the image buffer, frame skipping, frame pool and color format settings
+		 * of this configuration.
+		 * @return Stream worker which is not started yet.
+		 */
+		PTR_STREAM_WORKER CreateWorker() const;
+
+		/**
+		 * Stop current running execution if it's executes. Returns immediately, can be called from any thread.
+		 * @param mode Shutdown mode to drain or to discard the stored frames.
 		 */
-		void Stop();
+		void Stop(Thread::ShutdownMode mode = Thread::ShutdownMode::DRAIN);
 
 		/**
 		 * Obtain streaming source pointer if set.
@@ -98,6 +116,20 @@ namespace Companion
 		 */
 		void SkipFrame(int skipFrame);
 
+		/**
+		 * Get latency budget for adaptive frame skipping.
+		 * @return Latency budget in milliseconds, 0 if adaptive frame skipping is not used.
+		 */
+		int LatencyBudget() const;
+
+		/**
+		 * Set latency budget to enable adaptive frame skipping. The skip frame rate is adapted to the measured image
+		 * processing time and source frame rate so that frames are processed within the given budget. The skip frame
+		 * rate which is set by SkipFrame() is used as minimum.
+		 * @param latencyBudget Latency budget in milliseconds. If latencyBudget <= 0 adaptive frame skipping is not used.
+		 */
+		void LatencyBudget(int latencyBudget);
+
 		/**
 		 * Get image buffer store rate.
 		 * @return Image buffer frame rate default 5 images are stored to buffer.
@@ -110,6 +142,63 @@ namespace Companion
 		 */
 		void ImageBuffer(int imageBuffer);
 
+		/**
+		 * Get number of consumer threads.
+		 * @return Number of consumer threads which process images in parallel. Default is one thread.
+		 */
+		int ConsumerThreads() const;
+
+		/**
+		 * Set number of consumer threads which process images in parallel. Results are still returned in frame order.
+		 * If more than one consumer thread is used the image processing must be safe to be executed concurrently.
+		 * @param consumerThreads Number of consumer threads. If consumerThreads <= 0 one consumer thread will be used.
+		 */
+		void ConsumerThreads(int consumerThreads);
+
+		/**
+		 * Get wait policy of the stream worker threads.
+		 * @return Wait policy which is used if the image buffer is full or empty. Default is blocking.
+		 */
+		Thread::WaitPolicy WaitPolicy() const;
+
+		/**
+		 * Set wait policy of the stream worker threads.
+		 * @param waitPolicy Wait policy which is used if the image buffer is full or empty.
+		 */
+		void WaitPolicy(Thread::WaitPolicy waitPolicy);
+
+		/**
+		 * Get backpressure policy of the image buffer.
+		 * @return Policy which is used if the image buffer is full. Default is blocking the producer.
+		 */
+		Thread::BackpressurePolicy Backpressure() const;
+
+		/**
+		 * Set backpressure policy of the image buffer. Live sources should drop frames to keep latency low.
+		 * @param backpressure Policy which is used if the image buffer is full.
+		 */
+		void Backpressure(Thread::BackpressurePolicy backpressure);
+
+		/**
+		 * Get number of frames which were dropped by the backpressure policy in the current or last execution.
+		 * @return Number of dropped frames.
+		 */
+		unsigned long DroppedFrames() const;
+
+		/**
+		 * Get frame pool if set.
+		 * @return Frame pool which recycles image buffers or nullptr if no frame pool is used.
+		 */
+		PTR_FRAME_POOL FramePool() const;
+
+		/**
+		 * Set a frame pool which recycles image buffers of the streaming source and of the images in the result callback.
+		 * A buffer returns to the pool when the result callback has finished and no other reference to its image exists.
+		 * The pool should hold more buffers than the image buffer size plus the number of consumer threads.
+		 * @param framePool Frame pool to use or nullptr to allocate new images for each frame.
+		 */
+		void FramePool(PTR_FRAME_POOL framePool);
+
 		/**
 		 * Set a result callback handler.
 		 * The source image will be converted to the given format.
@@ -155,40 +244,55 @@ namespace Companion
 		 */
 		PTR_STREAM source;
 
+		/**
+		 * Frame pool to recycle image buffers.
+		 */
+		PTR_FRAME_POOL framePool;
+
 		/**
 		 * Image processing implementation, for example an object detection or recognition.
 		 */
 		PTR_IMAGE_PROCESSING processing;
 
 		/**
-		 * Stream worker which runs an single job.
+		 * Handle of the current or last execution.
 		 */
-		PTR_STREAM_WORKER worker;
+		PTR_STREAM_HANDLE handle;
+
+		/**
+		 * Mutex to lock the execution handle.
+		 */
+		mutable std::mutex handleMx;
 
 		/**
 		 * Number of frames to skip to process next image.
 		 */
 		int skipFrame;
 
+		/**
+		 * Latency budget for adaptive frame skipping in milliseconds, 0 if not used.
+		 */
+		int latencyBudget;
+
 		/**
 		 * Image buffer size to store image. Default is 5.
 		 */
 		int imageBuffer;
 
 		/**
-		 * Indicator if threads are currently running.
+		 * Number of consumer threads to process images. Default is one thread.
 		 */
-		bool threadsRunning;
+		int consumerThreads;
 
 		/**
-		 * Consumer thread to store image data.
+		 * Wait policy of the stream worker threads.
 		 */
-		std::thread consumer;
+		Thread::WaitPolicy waitPolicy;
 
 		/**
-		 * Producer thread to image processing given image data.
+		 * Backpressure policy of the image buffer.
 		 */
-		std::thread producer;
+		Thread::BackpressurePolicy backpressure;
 
 		/**
 		 * Color format of the image in the result callback.
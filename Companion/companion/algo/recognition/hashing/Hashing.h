@@ -61,6 +61,17 @@ namespace Companion {
 					virtual PTR_RESULT_RECOGNITION ExecuteAlgorithm(PTR_MODEL_IMAGE_HASHING model,
 						cv::Mat query, PTR_DRAW_FRAME roi) = 0;
 
+					/**
+					 * Specific algorithm implementation for a hashing process of several queries, for example all ROIs of
+					 * one frame. Queries are compared with the hash model in one batch.
+					 * @param model Image hash model to compare.
+					 * @param queries Query images to compare with hash model, all with the size of the model images.
+					 * @param rois Region of interest of each query.
+					 * @return Ranked recognition results of each query in the order of the queries, best result first.
+					 */
+					virtual std::vector<std::vector<PTR_RESULT_RECOGNITION>> ExecuteAlgorithm(PTR_MODEL_IMAGE_HASHING model,
+						const std::vector<cv::Mat>& queries, const std::vector<PTR_DRAW_FRAME>& rois) = 0;
+
 					/**
 					 * Indicator if this algorithm uses cuda.
 					 * @return True if cuda will be used otherwise false for CPU/OpenCL usage.
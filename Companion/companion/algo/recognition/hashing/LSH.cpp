@@ -18,49 +18,110 @@
 
 #include "LSH.h"
 
+Companion::Algorithm::Recognition::Hashing::LSH::LSH()
+{
+	this->topK = 1;
+}
+
 PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Hashing::LSH::ExecuteAlgorithm(PTR_MODEL_IMAGE_HASHING model,
 	cv::Mat query,
 	PTR_DRAW_FRAME roi)
 {
-	PTR_RESULT_RECOGNITION result = nullptr;
-	std::vector<std::pair<int, float>> scores = model->Scores();
-	std::pair<cv::Mat_<float>, cv::Mat> dataset = model->GenerateDataset();
-	cv::Mat_<float> hashImages = dataset.first;
-	cv::Mat datasetImages = dataset.second;
+	std::vector<PTR_RESULT_RECOGNITION> rank;
+
+	rank = ExecuteAlgorithm(model, std::vector<cv::Mat>{ query }, std::vector<PTR_DRAW_FRAME>{ roi }).front();
+	return rank.empty() ? nullptr : rank.front();
+}
 
-	query.reshape(1, 1).convertTo(query, CV_32F);
-	query = query * hashImages;
+std::vector<std::vector<PTR_RESULT_RECOGNITION>> Companion::Algorithm::Recognition::Hashing::LSH::ExecuteAlgorithm(PTR_MODEL_IMAGE_HASHING model,
+	const std::vector<cv::Mat>& queries,
+	const std::vector<PTR_DRAW_FRAME>& rois)
+{
+	std::vector<std::vector<PTR_RESULT_RECOGNITION>> results(queries.size());
+	PTR_HASH_INDEX index = model->Index();
+	cv::Mat queryImages, projection, bits;
+	cv::Mat row;
+	std::vector<uint64_t> hashes;
+	std::vector<std::pair<int, int>> rank;
+	const uint64_t* queryHash;
+	int models;
+	int k;
 
-	for (size_t i = 0; i < query.rows; i++)
+	if (queries.size() != rois.size())
 	{
-		for (size_t j = 0; j < query.cols; j++)
-		{
-			query.at<float>(i, j) = query.at<float>(i, j) > 0 ? 1 : 0;
-		}
+		throw Companion::Error::Code::dimension_error;
 	}
 
-	query.convertTo(query, CV_8U);
+	if (queries.empty() || index->IsEmpty())
+	{
+		return results;
+	}
 
-	//Search for similar samples in the dataset
-	for (size_t row = 0; row < datasetImages.rows; ++row)
+	// Stack all queries as rows of one matrix
+	queryImages.create(static_cast<int>(queries.size()), index->Projection().rows, CV_32F);
+	for (size_t i = 0; i < queries.size(); i++)
 	{
-		scores[row].second = norm(query, datasetImages.row(row), cv::NORM_HAMMING);
+		if (queries[i].total() * queries[i].channels() != static_cast<size_t>(index->Projection().rows))
+		{
+			throw Companion::Error::Code::dimension_error;
+		}
+
+		row = queryImages.row(static_cast<int>(i));
+		queries[i].reshape(1, 1).convertTo(row, CV_32F);
 	}
 
-	//Make a copy of scores and rank them
-	std::vector<std::pair<int, float>> rank;
-	rank.assign(scores.begin(), scores.end());
-	sort(rank.begin(), rank.end(), SortRank());
+	// Project all queries with one matrix multiplication
+	cv::gemm(queryImages, index->Projection(), 1.0, cv::noArray(), 0.0, projection);
+
+	// Positive projections are hash bits which are packed into 64 bit words
+	cv::compare(projection, 0.0, bits, cv::CMP_GT);
+	HASH_INDEX::Pack(bits, hashes);
 
-	for (size_t r = 0; r < std::min(10, (int)rank.size()); ++r)
+	models = static_cast<int>(index->Ids().size());
+	k = std::min(this->topK, models);
+	rank.resize(models);
+	for (size_t i = 0; i < queries.size(); i++)
 	{
-		if (r == 0)
+		// Hamming distance of the query to each model by XOR and population count
+		queryHash = hashes.data() + i * index->Words();
+		for (int j = 0; j < models; j++)
+		{
+			rank[j] = { j, index->Distance(queryHash, j) };
+		}
+
+		// Only the top k models are selected and sorted
+		std::nth_element(rank.begin(), rank.begin() + (k - 1), rank.end(), SortRank());
+		std::sort(rank.begin(), rank.begin() + k, SortRank());
+
+		for (int r = 0; r < k; r++)
 		{
-			result = std::make_shared<RESULT_RECOGNITION>(static_cast<int>(rank.at(r).second), rank.at(r).first, roi);
+			results[i].push_back(std::make_shared<RESULT_RECOGNITION>(Scoring(rank[r].second, index->HashSize()),
+				index->Ids().at(rank[r].first),
+				rois[i]));
 		}
 	}
 
-	return result;
+	return results;
+}
+
+int Companion::Algorithm::Recognition::Hashing::LSH::TopK() const
+{
+	return this->topK;
+}
+
+void Companion::Algorithm::Recognition::Hashing::LSH::TopK(int topK)
+{
+	if (topK <= 0)
+	{
+		topK = 1;
+	}
+
+	this->topK = topK;
+}
+
+int Companion::Algorithm::Recognition::Hashing::LSH::Scoring(int distance, int hashSize)
+{
+	return hashSize > 0 ? cvRound(100.0 * (hashSize - distance) / hashSize) : 0;
 }
 
 bool Companion::Algorithm::Recognition::Hashing::LSH::IsCuda() const
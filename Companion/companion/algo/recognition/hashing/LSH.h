@@ -19,7 +19,11 @@
 #ifndef COMPANION_LSH_H
 #define COMPANION_LSH_H
 
+#include <algorithm>
+#include <vector>
+#include <cstdint>
 #include "Hashing.h"
+#include <companion/util/CompanionError.h>
 
 namespace Companion {
 	namespace Algorithm {
@@ -34,20 +38,68 @@ namespace Companion {
 
 				public:
 
+					/**
+					 * LSH constructor which returns only the best result of each query.
+					 */
+					LSH();
+
 					/**
 					 * LSH algorithm execution method to compare an image hash model with a query.
 					 * @param model Image hash model to compare.
 					 * @param query Query image to compare with hash model.
 					 * @param roi Region of interest to check.
-					 * @return Nullptr if no matching success otherwise a recognition result.
+					 * @return Nullptr if no matching success otherwise the best recognition result.
 					 */
 					PTR_RESULT_RECOGNITION ExecuteAlgorithm(PTR_MODEL_IMAGE_HASHING model, cv::Mat query, PTR_DRAW_FRAME roi);
 
+					/**
+					 * LSH algorithm execution method to compare an image hash model with several queries. All queries are
+					 * projected with one matrix multiplication, packed into 64 bit words and compared with the prebuilt hash
+					 * index of the model by XOR and population count.
+					 * Only the top k models of each query are selected and sorted.
+					 * @param model Image hash model to compare.
+					 * @param queries Query images to compare with hash model, all with the size of the model images.
+					 * @param rois Region of interest of each query.
+					 * @throws Companion::Error::CompanionException if queries and ROIs or the query sizes do not match.
+					 * @return Top k recognition results of each query in the order of the queries, best result first.
+					 * Scoring of a result is the percentage of equal hash bits.
+					 */
+					std::vector<std::vector<PTR_RESULT_RECOGNITION>> ExecuteAlgorithm(PTR_MODEL_IMAGE_HASHING model,
+						const std::vector<cv::Mat>& queries,
+						const std::vector<PTR_DRAW_FRAME>& rois);
+
+					/**
+					 * Get number of ranked results of each query.
+					 * @return Number of results of each query.
+					 */
+					int TopK() const;
+
+					/**
+					 * Set number of ranked results of each query.
+					 * @param topK Number of results of each query, at least one.
+					 */
+					void TopK(int topK);
+
 					/**
 					 * Indicator if this algorithm uses cuda.
 					 * @return True if cuda will be used otherwise false for CPU/OpenCL usage.
 					 */
 					bool IsCuda() const;
+
+				private:
+
+					/**
+					 * Number of ranked results of each query.
+					 */
+					int topK;
+
+					/**
+					 * Calculate scoring of a result from the hamming distance of its hash.
+					 * @param distance Hamming distance between query hash and model hash.
+					 * @param hashSize Number of hash bits.
+					 * @return Percentage of equal hash bits between 0 and 100.
+					 */
+					static int Scoring(int distance, int hashSize);
 				};
 			}
 		}
@@ -87,28 +87,52 @@ PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Matching::FeatureMatch
 	PTR_MODEL_FEATURE_MATCHING objectModel,
 	PTR_DRAW_FRAME roi)
 {
+	return ExecuteAlgorithm(sceneModel, objectModel, roi, nullptr);
+}
+
+PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Matching::FeatureMatching::ExecuteAlgorithm(
+	PTR_MODEL_FEATURE_MATCHING sceneModel,
+	PTR_MODEL_FEATURE_MATCHING objectModel,
+	PTR_DRAW_FRAME roi,
+	PTR_TRACKING_STATE state)
+{
+	return Search(sceneModel, objectModel, roi, state, true);
+}
+
+PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Matching::FeatureMatching::SearchIRA(
+	PTR_MODEL_FEATURE_MATCHING sceneModel,
+	PTR_MODEL_FEATURE_MATCHING objectModel,
+	PTR_TRACKING_STATE state)
+{
+
+	if (this->cudaUsed || !this->useIRA || state == nullptr || !state->Ira()->IsObjectRecognized())
+	{
+		return nullptr;
+	}
+
+	return Search(sceneModel, objectModel, nullptr, state, false);
+}
+
+PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Matching::FeatureMatching::Search(
+	PTR_MODEL_FEATURE_MATCHING sceneModel,
+	PTR_MODEL_FEATURE_MATCHING objectModel,
+	PTR_DRAW_FRAME roi,
+	PTR_TRACKING_STATE state,
+	bool searchScene)
+{
 
 	// Set of variables for feature matching
 	cv::Mat sceneImage, objectImage;
-	std::vector<std::vector<cv::DMatch>> matches;
-	std::vector<cv::DMatch> goodMatches;
-	std::vector<cv::KeyPoint> keypointsScene, keypointsObject;
-	cv::Mat descriptorsScene, descriptorsObject;
+	std::vector<cv::KeyPoint> sceneKeypoints;
+	cv::Mat sceneDescriptors;
 	PTR_RESULT_RECOGNITION result = nullptr;
 	PTR_DRAW drawable = nullptr;
-	bool isIRAUsed = false;
-	bool isROIUsed = false;
-	PTR_IMAGE_REDUCTION_ALGORITHM ira;
-
-	// Clear all lists from last run
-	matches.clear();
-	goodMatches.clear();
-	keypointsScene.clear();
-	keypointsObject.clear();
+	bool isSceneDetected = false;
+	bool isRepeated = false;
+	int scoring = 0;
 
 	sceneImage = sceneModel->Image(); // Get image scene
 	objectImage = objectModel->Image(); // Get object scene
-	ira = objectModel->Ira();  // Get IRA from object model
 
 	// Check if images are loaded...
 	if (!Util::IsImageLoaded(sceneImage) || !Util::IsImageLoaded(objectImage))
@@ -116,103 +140,56 @@ PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Matching::FeatureMatch
 		throw Companion::Error::Code::image_not_found;
 	}
 
-	cvtColor(sceneImage, sceneImage, cv::COLOR_BGR2GRAY); // Convert image to grayscale
-
-	// --------------------------------------------------
-	// Scene and model preparation start
-	// --------------------------------------------------
-
-	// ------ IRA scene handling. Currently works only for CPU usage ------
-	if (this->useIRA && ira->IsObjectRecognized()) // IRA USED & OBJECT RECOGNIZED
-	{
-		// Cut out scene from last recognized object and set this as new scene to check
-		sceneImage = cv::Mat(sceneImage, ira->LastObjectPosition());
-
-		// Detect keypoints from cut scene
-		this->detector->detect(sceneImage, keypointsScene);
-		// Calculate descriptors from cut scene (feature vectors)
-		this->extractor->compute(sceneImage, keypointsScene, descriptorsScene);
-
-		isIRAUsed = true;
-	}
-	else if (this->useIRA && roi != nullptr) // IRA USED & OBJECT NOT RECOGNIZED & ROI EXISTS
-	{
-		// Get ROI position
-		cv::Rect roiObject(roi->TopLeft(), roi->BottomRight());
-
-		// Cut out scene from last recognized object and set this as new scene to check
-		sceneImage = cv::Mat(sceneImage, roiObject);
-
-		// Detect keypoints from cut scene
-		this->detector->detect(sceneImage, keypointsScene);
-		// Calculate descriptors from cut scene (feature vectors)
-		this->extractor->compute(sceneImage, keypointsScene, descriptorsScene);
-
-		isROIUsed = true;
-	}
-	else if (this->useIRA && sceneModel->KeypointsCalculated()) // IRA USED & OBJECT NOT RECOGNIZED & SCENE KEYPOINTS CALCULATED
-	{
-		keypointsScene = sceneModel->Keypoints();
-		descriptorsScene = sceneModel->Descriptors();
-	}
-	else if (!this->cudaUsed) // IRA NOT USED & OBJECT NOT RECOGNIZED & SCENE KEYPOINTS NOT CALCULATED & NOT CUDA USAGE
-	{
-		// Detect keypoints
-		this->detector->detect(sceneImage, keypointsScene);
-		// Calculate descriptors
-		this->extractor->compute(sceneImage, keypointsScene, descriptorsScene);
-	}
-
 	// Check if object has calculated keypoints and descriptors and CUDA is not used
-	if (!objectModel->KeypointsCalculated() && !this->cudaUsed)
-	{
-		objectModel->CalculateKeyPointsAndDescriptors(this->detector, this->extractor); // Calculate keypoints from model
-	}
+	PrepareModel(objectModel);
 
-	// Get keypoints and descriptors from model
-	keypointsObject = objectModel->Keypoints();
-	descriptorsObject = objectModel->Descriptors();
-
-	// --------------------------------------------------
-	// Scene and model preparation end
-	// --------------------------------------------------
-
-	// --------------------------------------------------
-	// Feature matching algorithm
-	// --------------------------------------------------
-	// If object and scene descriptor and keypoints exists..
-	if (!this->cudaUsed && !descriptorsObject.empty() && !descriptorsScene.empty() && !keypointsObject.empty() && !keypointsScene.empty())
+	if (!this->cudaUsed)
 	{
-		// If matching type is flan based, scene and object must be in CV_32F format
-		if (matcherType == cv::DescriptorMatcher::FLANNBASED)
+		// Scene features calculated once for all models are shared by all search steps
+		if (sceneModel->KeypointsCalculated())
 		{
-			descriptorsScene.convertTo(descriptorsScene, CV_32F);
-			descriptorsObject.convertTo(descriptorsObject, CV_32F);
+			sceneKeypoints = sceneModel->Keypoints();
+			sceneDescriptors = sceneModel->Descriptors();
+			isSceneDetected = true;
 		}
 
-		// ------ CPU USAGE ------
-		// matching descriptor vectors
-		matcher->knnMatch(descriptorsObject, descriptorsScene, matches, DEFAULT_NEIGHBOR);
+		// ------ Search steps from IRA area to full scene or in the ROI only, the first recognition is returned ------
+		if (roi != nullptr) // ROI EXISTS
+		{
+			// Search only in the region of interest, IRA and full scene are searched once per frame by the caller
+			drawable = MatchArea(sceneModel, objectModel, state, roi, false, true, isRepeated, sceneKeypoints, sceneDescriptors, isSceneDetected, scoring);
+		}
+		else
+		{
+			if (this->useIRA && state != nullptr && state->Ira()->IsObjectRecognized()) // IRA USED & OBJECT RECOGNIZED
+			{
+				// Search only in the area of the last recognized object
+				drawable = MatchArea(sceneModel, objectModel, state, roi, true, false, isRepeated, sceneKeypoints, sceneDescriptors, isSceneDetected, scoring);
+				isRepeated = true;
 
-		// Ratio test for good matches - http://www.cs.ubc.ca/~lowe/papers/ijcv04.pdf#page=20
-		// Neighbourhoods comparison
-		RatioTest(matches, goodMatches, DEFAULT_RATIO_VALUE);
+				if (drawable == nullptr)
+				{
+					state->Ira()->Clear(); // Clear last recognized object position
+				}
+			}
 
-		drawable = ObtainMatchingResult(sceneImage,
-			objectImage,
-			goodMatches,
-			keypointsObject,
-			keypointsScene,
-			sceneModel,
-			objectModel,
-			isIRAUsed,
-			isROIUsed,
-			roi);
+			if (drawable == nullptr && searchScene)
+			{
+				// Search in the full scene
+				drawable = MatchArea(sceneModel, objectModel, state, roi, false, false, isRepeated, sceneKeypoints, sceneDescriptors, isSceneDetected, scoring);
+			}
+		}
 	}
 #if Companion_USE_CUDA
-	else if (cudaUsed)
+	else if (roi == nullptr && searchScene)
 	{
-		// ------ Cuda USAGE ------
+		// ------ Cuda USAGE, only the full scene is searched ------
+		std::vector<std::vector<cv::DMatch>> matches;
+		std::vector<cv::DMatch> goodMatches;
+		std::vector<cv::KeyPoint> keypointsScene, keypointsObject;
+
+		cvtColor(sceneImage, sceneImage, cv::COLOR_BGR2GRAY); // Convert image to grayscale
+
 		if (cv::cuda::getCudaEnabledDeviceCount() == 0)
 		{
 			throw Companion::Error::Code::no_cuda_device;
@@ -247,46 +224,372 @@ PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Matching::FeatureMatch
 		// ToDo := SURF_CUDA results are not good
 		// Ratio test for good matches - http://www.cs.ubc.ca/~lowe/papers/ijcv04.pdf#page=20
 		// Neighborhoods comparison
-		RatioTest(matches, goodMatches, DEFAULT_RATIO_VALUE);
+		RatioTest(matches, goodMatches, this->ratio);
 
-		drawable = ObtainMatchingResult(sceneImage,
-			objectImage,
+		drawable = ObtainMatchingResult(objectImage,
 			goodMatches,
 			keypointsObject,
 			keypointsScene,
 			sceneModel,
-			objectModel,
-			isIRAUsed,
-			isROIUsed,
-			roi);
+			state,
+			false,
+			false,
+			roi,
+			scoring);
 	}
 #endif
-	else
-	{
-		// If results are not good enough and empty for keypoints and descriptors
-		sceneImage.release();
-		objectImage.release();
-		RepeatAlgorithm(sceneModel, objectModel, roi, isIRAUsed, ira, isROIUsed);
-	}
 
 	if (drawable != nullptr)
 	{
-		// TODO := SCORING CALCULATION
 		// Object found
-		result = std::make_shared<RESULT_RECOGNITION>(100, objectModel->ID(), drawable);
+		result = std::make_shared<RESULT_RECOGNITION>(scoring, objectModel->ID(), drawable);
+	}
+
+	sceneImage.release();
+	objectImage.release();
+
+	return result;
+}
 
-		sceneImage.release();
-		objectImage.release();
+std::vector<PTR_RESULT_RECOGNITION> Companion::Algorithm::Recognition::Matching::FeatureMatching::FindInstances(
+	PTR_MODEL_FEATURE_MATCHING sceneModel,
+	PTR_MODEL_FEATURE_MATCHING objectModel,
+	PTR_DRAW_FRAME roi,
+	PTR_TRACKING_STATE state)
+{
+	std::vector<PTR_RESULT_RECOGNITION> results;
+	PTR_RESULT_RECOGNITION result;
+
+	if (this->maxInstances <= 1 || this->cudaUsed)
+	{
+		// Single instance search with IRA support
+		result = ExecuteAlgorithm(sceneModel, objectModel, roi, state);
+		if (result != nullptr)
+		{
+			results.push_back(result);
+		}
+		return results;
 	}
-	else if (isIRAUsed || isROIUsed)
+
+	return SearchInstances(sceneModel, objectModel, roi);
+}
+
+std::vector<PTR_RESULT_RECOGNITION> Companion::Algorithm::Recognition::Matching::FeatureMatching::FindCandidates(
+	PTR_MODEL_FEATURE_MATCHING sceneModel,
+	PTR_MODEL_FEATURE_MATCHING objectModel)
+{
+
+	if (this->cudaUsed)
 	{
-		// No results and IRA or ROI was used
-		sceneImage.release();
-		objectImage.release();
-		RepeatAlgorithm(sceneModel, objectModel, roi, isIRAUsed, ira, isROIUsed);
+		return std::vector<PTR_RESULT_RECOGNITION>();
 	}
 
-	return result;
+	return SearchInstances(sceneModel, objectModel, nullptr);
+}
+
+std::vector<PTR_RESULT_RECOGNITION> Companion::Algorithm::Recognition::Matching::FeatureMatching::SearchInstances(
+	PTR_MODEL_FEATURE_MATCHING sceneModel,
+	PTR_MODEL_FEATURE_MATCHING objectModel,
+	PTR_DRAW_FRAME roi)
+{
+	std::vector<PTR_RESULT_RECOGNITION> results;
+	cv::Mat sceneImage, objectImage;
+	std::vector<cv::DMatch> goodMatches;
+	std::vector<cv::KeyPoint> keypointsScene, keypointsObject;
+	cv::Mat descriptorsScene, descriptorsObject;
+	PTR_DRAW drawable;
+	cv::Rect searchArea;
+	bool isROIUsed = false;
+	int scoring = 0;
+
+	sceneImage = sceneModel->Image();
+	objectImage = objectModel->Image();
+
+	if (!Util::IsImageLoaded(sceneImage) || !Util::IsImageLoaded(objectImage))
+	{
+		throw Companion::Error::Code::image_not_found;
+	}
+
+	if (roi != nullptr)
+	{
+		// Search only in the region of interest
+		searchArea = cv::Rect(roi->TopLeft(), roi->BottomRight()) & cv::Rect(0, 0, sceneImage.cols, sceneImage.rows);
+		isROIUsed = true;
+	}
+
+	SceneFeatures(sceneModel, searchArea, isROIUsed, keypointsScene, descriptorsScene);
+
+	PrepareModel(objectModel);
+	keypointsObject = objectModel->Keypoints();
+	descriptorsObject = objectModel->Descriptors();
+
+	if (descriptorsObject.empty() || descriptorsScene.empty() || keypointsObject.empty() || keypointsScene.empty())
+	{
+		return results;
+	}
+
+	MatchInstances(descriptorsObject, descriptorsScene, goodMatches);
+
+	// Each found instance removes its matches, so the next iteration searches for another instance
+	while (static_cast<int>(results.size()) < this->maxInstances && goodMatches.size() >= static_cast<size_t>(this->countMatches))
+	{
+		if (!ObtainInstance(objectImage, goodMatches, keypointsObject, keypointsScene, sceneModel, isROIUsed, roi, drawable, scoring))
+		{
+			break;
+		}
+
+		if (drawable != nullptr)
+		{
+			results.push_back(std::make_shared<RESULT_RECOGNITION>(scoring, objectModel->ID(), drawable));
+		}
+	}
+
+	return results;
+}
+
+PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Matching::FeatureMatching::TrackObject(const cv::Mat& sceneGray,
+	PTR_MODEL_FEATURE_MATCHING objectModel,
+	PTR_TRACKING_STATE state)
+{
+	PTR_OBJECT_TRACK track;
+	std::vector<cv::Point2f> nextPoints, objectPoints, previousPoints, scenePoints;
+	std::vector<cv::Point2f> trackedObject, trackedScene;
+	std::vector<cv::Point2f> obj_corners(4), scene_corners(4);
+	std::vector<uchar> status, inliers;
+	std::vector<float> errors;
+	cv::Mat previousGray, increment, homography;
+	cv::Rect imageArea = cv::Rect(0, 0, sceneGray.cols, sceneGray.rows);
+	cv::Rect searchArea;
+	PTR_DRAW_FRAME frame;
+	int minPoints;
+
+	if (this->trackingInterval <= 0 || this->cudaUsed || state == nullptr || !state->Track()->IsTracking() || sceneGray.empty())
+	{
+		return nullptr;
+	}
+
+	track = state->Track();
+
+	if (track->Frames() >= this->trackingInterval || track->SceneImage().size() != sceneGray.size())
+	{
+		// Object must be recognized by feature matching again
+		track->Clear();
+		return nullptr;
+	}
+
+	// Image of the recognition is converted once, following images are stored in grayscale
+	previousGray = track->SceneImage();
+	if (previousGray.channels() > 1)
+	{
+		Util::ConvertColor(previousGray, previousGray, ColorFormat::GRAY);
+	}
+
+	cv::calcOpticalFlowPyrLK(previousGray, sceneGray, track->ScenePoints(), nextPoints, status, errors,
+		cv::Size(TRACK_WINDOW, TRACK_WINDOW), TRACK_LEVELS);
+
+	for (size_t i = 0; i < nextPoints.size(); i++)
+	{
+		if (status[i] && imageArea.contains(nextPoints[i]))
+		{
+			objectPoints.push_back(track->ObjectPoints()[i]);
+			previousPoints.push_back(track->ScenePoints()[i]);
+			scenePoints.push_back(nextPoints[i]);
+		}
+	}
+
+	// Track quality is the share of the points of the recognition which are still followed
+	minPoints = std::max(static_cast<int>(MIN_TRACK_POINTS), static_cast<int>(std::ceil(track->StartPoints() * MIN_TRACK_QUALITY)));
+	if (static_cast<int>(scenePoints.size()) < minPoints)
+	{
+		track->Clear();
+		return nullptr;
+	}
+
+	// Motion between both frames updates the homography of the object
+	increment = cv::findHomography(previousPoints, scenePoints, cv::RANSAC, this->reprojThreshold, inliers, this->ransacMaxIters);
+	if (increment.empty())
+	{
+		track->Clear();
+		return nullptr;
+	}
+
+	for (size_t i = 0; i < inliers.size(); i++)
+	{
+		if (inliers[i])
+		{
+			trackedObject.push_back(objectPoints[i]);
+			trackedScene.push_back(scenePoints[i]);
+		}
+	}
+
+	if (static_cast<int>(trackedScene.size()) < minPoints)
+	{
+		track->Clear();
+		return nullptr;
+	}
+
+	homography = increment * track->Homography();
+
+	obj_corners[0] = cv::Point2f(0, 0);
+	obj_corners[1] = cv::Point2f(objectModel->Image().cols, 0);
+	obj_corners[2] = cv::Point2f(objectModel->Image().cols, objectModel->Image().rows);
+	obj_corners[3] = cv::Point2f(0, objectModel->Image().rows);
+	cv::perspectiveTransform(obj_corners, scene_corners, homography);
+
+	if (!Companion::Util::ValidateShape(scene_corners[1], scene_corners[3], scene_corners[0], scene_corners[2], this->minSidelLength))
+	{
+		track->Clear();
+		return nullptr;
+	}
+
+	frame = std::make_shared<DRAW_FRAME>(scene_corners[0], scene_corners[1], scene_corners[3], scene_corners[2]);
+	track->Update(trackedObject, trackedScene, homography, sceneGray);
+
+	if (this->useIRA)
+	{
+		// IRA follows the tracked object, so the next recognition searches its area
+		searchArea = IRA::SearchArea(scene_corners, sceneGray.size());
+		state->Ira()->LastObjectPosition(searchArea.x, searchArea.y, searchArea.width, searchArea.height);
+	}
+
+	return std::make_shared<RESULT_RECOGNITION>(track->Scoring() * static_cast<int>(trackedScene.size()) / track->StartPoints(),
+		objectModel->ID(),
+		frame);
+}
+
+PTR_DESCRIPTOR_INDEX Companion::Algorithm::Recognition::Matching::FeatureMatching::CreateIndex(const std::vector<PTR_MODEL_FEATURE_MATCHING>& objectModels)
+{
+
+	for (const PTR_MODEL_FEATURE_MATCHING& objectModel : objectModels)
+	{
+		PrepareModel(objectModel);
+	}
+
+	return std::make_shared<DESCRIPTOR_INDEX>(this->matcher, this->matcherType, objectModels);
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::MatchIndex(PTR_DESCRIPTOR_INDEX index,
+	PTR_MODEL_FEATURE_MATCHING sceneModel,
+	std::vector<std::vector<cv::DMatch>>& modelMatches)
+{
+	index->Match(sceneModel->Descriptors(), this->ratio, modelMatches);
+}
+
+PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Matching::FeatureMatching::VerifyMatches(PTR_MODEL_FEATURE_MATCHING sceneModel,
+	PTR_MODEL_FEATURE_MATCHING objectModel,
+	std::vector<cv::DMatch> goodMatches)
+{
+	cv::Mat objectImage = objectModel->Image();
+	std::vector<cv::KeyPoint> keypointsScene = sceneModel->Keypoints();
+	std::vector<cv::KeyPoint> keypointsObject = objectModel->Keypoints();
+	PTR_DRAW drawable = nullptr;
+	int scoring = 0;
+
+	if (goodMatches.size() < static_cast<size_t>(this->countMatches))
+	{
+		return nullptr;
+	}
+
+	// Keep only the best matches like the ratio test of a single model
+	SelectMatches(goodMatches);
+
+	drawable = ObtainMatchingResult(objectImage,
+		goodMatches,
+		keypointsObject,
+		keypointsScene,
+		sceneModel,
+		nullptr,
+		false,
+		false,
+		nullptr,
+		scoring);
+
+	if (drawable == nullptr)
+	{
+		return nullptr;
+	}
+
+	return std::make_shared<RESULT_RECOGNITION>(scoring, objectModel->ID(), drawable);
+}
+
+int Companion::Algorithm::Recognition::Matching::FeatureMatching::TrackingInterval() const
+{
+	return this->trackingInterval;
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::TrackingInterval(int trackingInterval)
+{
+
+	if (trackingInterval <= 0)
+	{
+		trackingInterval = 0;
+	}
+
+	this->trackingInterval = trackingInterval;
+}
+
+int Companion::Algorithm::Recognition::Matching::FeatureMatching::MaxInstances() const
+{
+	return this->maxInstances;
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::MaxInstances(int maxInstances)
+{
+
+	if (maxInstances <= 0)
+	{
+		maxInstances = 1;
+	}
+
+	this->maxInstances = maxInstances;
+}
+
+int Companion::Algorithm::Recognition::Matching::FeatureMatching::CountMatches() const
+{
+	return this->countMatches;
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::CountMatches(int countMatches)
+{
+
+	if (countMatches <= 0)
+	{
+		countMatches = 40;
+	}
+
+	this->countMatches = countMatches;
+}
+
+float Companion::Algorithm::Recognition::Matching::FeatureMatching::Ratio() const
+{
+	return this->ratio;
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::Ratio(float ratio)
+{
+
+	if (ratio <= 0.0f || ratio > 1.0f)
+	{
+		ratio = DEFAULT_RATIO_VALUE;
+	}
+
+	this->ratio = ratio;
+}
+
+float Companion::Algorithm::Recognition::Matching::FeatureMatching::DistanceBound() const
+{
+	return this->distanceBound;
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::DistanceBound(float distanceBound)
+{
+
+	if (distanceBound <= 0.0f)
+	{
+		distanceBound = 0.0f;
+	}
+
+	this->distanceBound = distanceBound;
 }
 
 bool Companion::Algorithm::Recognition::Matching::FeatureMatching::IsCuda() const
@@ -296,68 +599,260 @@ bool Companion::Algorithm::Recognition::Matching::FeatureMatching::IsCuda() cons
 
 void Companion::Algorithm::Recognition::Matching::FeatureMatching::CalculateKeyPoints(PTR_MODEL_FEATURE_MATCHING model)
 {
+	std::vector<cv::KeyPoint> keypoints;
+	cv::Mat descriptors;
+
 	if (!IsCuda())
 	{
-		model->CalculateKeyPointsAndDescriptors(this->detector, this->extractor);
+		DetectAndCompute(model->Image(), keypoints, descriptors);
+		model->Keypoints(keypoints);
+		model->Descriptors(descriptors);
+	}
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::DetectAndCompute(const cv::Mat& image,
+	std::vector<cv::KeyPoint>& keypoints,
+	cv::Mat& descriptors)
+{
+	cv::Mat grayImage = image;
+
+	if (image.channels() > 1)
+	{
+		cvtColor(image, grayImage, cv::COLOR_BGR2GRAY); // Convert image to grayscale
+	}
+
+	// Detect keypoints
+	this->detector->detect(grayImage, keypoints);
+	// Calculate descriptors
+	this->extractor->compute(grayImage, keypoints, descriptors);
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::SceneFeatures(PTR_MODEL_FEATURE_MATCHING sceneModel,
+	const cv::Rect& searchArea,
+	bool isAreaUsed,
+	std::vector<cv::KeyPoint>& keypoints,
+	cv::Mat& descriptors)
+{
+
+	if (sceneModel->KeypointsCalculated()) // SCENE KEYPOINTS CALCULATED ONCE FOR ALL MODELS
+	{
+		if (isAreaUsed)
+		{
+			// Use the scene features inside the searched area instead of detecting them again
+			FilterKeypoints(sceneModel->Keypoints(), sceneModel->Descriptors(), searchArea, keypoints, descriptors);
+		}
+		else
+		{
+			keypoints = sceneModel->Keypoints();
+			descriptors = sceneModel->Descriptors();
+		}
+	}
+	else if (searchArea.area() > 0 || !isAreaUsed) // SCENE KEYPOINTS NOT CALCULATED
+	{
+		// Detect keypoints and calculate descriptors only in the searched area
+		DetectAndCompute(isAreaUsed ? cv::Mat(sceneModel->Image(), searchArea) : sceneModel->Image(), keypoints, descriptors);
+	}
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::FilterKeypoints(const std::vector<cv::KeyPoint>& keypoints,
+	const cv::Mat& descriptors,
+	const cv::Rect& area,
+	std::vector<cv::KeyPoint>& areaKeypoints,
+	cv::Mat& areaDescriptors)
+{
+	std::vector<int> rows;
+	cv::KeyPoint keypoint;
+	cv::Point2f offset(static_cast<float>(area.x), static_cast<float>(area.y));
+
+	areaKeypoints.clear();
+	for (size_t i = 0; i < keypoints.size(); i++)
+	{
+		if (area.contains(keypoints[i].pt))
+		{
+			// Keypoints are moved into the coordinate system of the area
+			keypoint = keypoints[i];
+			keypoint.pt -= offset;
+			areaKeypoints.push_back(keypoint);
+			rows.push_back(static_cast<int>(i));
+		}
+	}
+
+	areaDescriptors.release();
+	if (rows.empty() || descriptors.empty())
+	{
+		return;
+	}
+
+	areaDescriptors.create(static_cast<int>(rows.size()), descriptors.cols, descriptors.type());
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		descriptors.row(rows[i]).copyTo(areaDescriptors.row(static_cast<int>(i)));
+	}
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::PrepareModel(PTR_MODEL_FEATURE_MATCHING objectModel)
+{
+
+	if (this->cudaUsed)
+	{
+		return;
+	}
+
+	// Models can be shared between streams, so they are calculated once
+	objectModel->Prepare([this, objectModel]()
+	{
+		if (this->featureCache == nullptr || !this->featureCache->Load(objectModel, this->featureCacheKey))
+		{
+			objectModel->CalculateKeyPointsAndDescriptors(this->detector, this->extractor); // Calculate keypoints from model
+
+			if (this->featureCache != nullptr)
+			{
+				this->featureCache->Store(objectModel, this->featureCacheKey);
+			}
+		}
+	});
+}
+
+PTR_DRAW Companion::Algorithm::Recognition::Matching::FeatureMatching::MatchArea(
+	PTR_MODEL_FEATURE_MATCHING sceneModel,
+	PTR_MODEL_FEATURE_MATCHING objectModel,
+	PTR_TRACKING_STATE state,
+	PTR_DRAW_FRAME roi,
+	bool isIRAUsed,
+	bool isROIUsed,
+	bool isRepeated,
+	std::vector<cv::KeyPoint>& sceneKeypoints,
+	cv::Mat& sceneDescriptors,
+	bool& isSceneDetected,
+	int& scoring)
+{
+
+	cv::Mat sceneImage = sceneModel->Image();
+	cv::Mat objectImage = objectModel->Image();
+	std::vector<std::vector<cv::DMatch>> matches;
+	std::vector<cv::DMatch> goodMatches;
+	std::vector<cv::KeyPoint> keypointsScene, keypointsObject;
+	cv::Mat descriptorsScene, descriptorsObject;
+	bool isAreaUsed = isIRAUsed || isROIUsed;
+	cv::Rect searchArea;
+
+	if (isIRAUsed)
+	{
+		searchArea = state->Ira()->LastObjectPosition();
+	}
+	else if (isROIUsed)
+	{
+		searchArea = cv::Rect(roi->TopLeft(), roi->BottomRight());
+	}
+	searchArea &= cv::Rect(0, 0, sceneImage.cols, sceneImage.rows);
+
+	if (!isSceneDetected && (isRepeated || !isAreaUsed))
+	{
+		// Full scene is detected once, all following steps select their area from it
+		DetectAndCompute(sceneImage, sceneKeypoints, sceneDescriptors);
+		isSceneDetected = true;
+	}
+
+	if (isSceneDetected && isAreaUsed)
+	{
+		FilterKeypoints(sceneKeypoints, sceneDescriptors, searchArea, keypointsScene, descriptorsScene);
+	}
+	else if (isSceneDetected)
+	{
+		keypointsScene = sceneKeypoints;
+		descriptorsScene = sceneDescriptors;
+	}
+	else if (searchArea.area() > 0)
+	{
+		// First step detects keypoints and calculates descriptors only in its area
+		DetectAndCompute(cv::Mat(sceneImage, searchArea), keypointsScene, descriptorsScene);
+	}
+
+	// Get keypoints and descriptors from model
+	keypointsObject = objectModel->Keypoints();
+	descriptorsObject = objectModel->Descriptors();
+
+	// If object and scene descriptor and keypoints exists..
+	if (descriptorsObject.empty() || descriptorsScene.empty() || keypointsObject.empty() || keypointsScene.empty())
+	{
+		return nullptr;
+	}
+
+	// If matching type is flan based, scene and object must be in CV_32F format
+	// Shared scene and object descriptors are not converted in place
+	if (matcherType == cv::DescriptorMatcher::FLANNBASED && descriptorsScene.type() != CV_32F)
+	{
+		descriptorsScene.convertTo(descriptorsScene, CV_32F);
+	}
+	if (matcherType == cv::DescriptorMatcher::FLANNBASED && descriptorsObject.type() != CV_32F)
+	{
+		descriptorsObject.convertTo(descriptorsObject, CV_32F);
 	}
-}
 
-PTR_RESULT_RECOGNITION Companion::Algorithm::Recognition::Matching::FeatureMatching::RepeatAlgorithm(
-	PTR_MODEL_FEATURE_MATCHING sceneModel,
-	PTR_MODEL_FEATURE_MATCHING objectModel,
-	PTR_DRAW_FRAME roi,
-	bool isIRAUsed,
-	PTR_IMAGE_REDUCTION_ALGORITHM ira,
-	bool isROIUsed)
-{
-	if (isIRAUsed)
+	if (matcherType == cv::DescriptorMatcher::BRUTEFORCE_HAMMING && HammingMatcher::IsSupported(descriptorsObject, descriptorsScene))
 	{
-		ira->Clear(); // Clear last recognized object position
-		return ExecuteAlgorithm(sceneModel, objectModel, roi); // Repeat algorithm and full scene or roi
+		// Binary descriptors are matched by the SIMD hamming matcher which applies the ratio test directly
+		HammingMatcher::Match(descriptorsObject, descriptorsScene, this->ratio, goodMatches, this->countMatches, this->distanceBound);
+
+		// Keep only the best matches like the ratio test
+		SelectMatches(goodMatches);
 	}
-	else if (isROIUsed)
+	else
 	{
-		return ExecuteAlgorithm(sceneModel, objectModel, nullptr); // Repeat algorithm and check full scene
+		// matching descriptor vectors
+		matcher->knnMatch(descriptorsObject, descriptorsScene, matches, DEFAULT_NEIGHBOR);
+
+		// Ratio test for good matches - http://www.cs.ubc.ca/~lowe/papers/ijcv04.pdf#page=20
+		// Neighbourhoods comparison
+		RatioTest(matches, goodMatches, this->ratio);
 	}
 
-	return nullptr;
+	return ObtainMatchingResult(objectImage,
+		goodMatches,
+		keypointsObject,
+		keypointsScene,
+		sceneModel,
+		state,
+		isIRAUsed,
+		isROIUsed,
+		roi,
+		scoring);
 }
 
 void Companion::Algorithm::Recognition::Matching::FeatureMatching::RatioTest(const std::vector<std::vector<cv::DMatch>>& matches,
 	std::vector<cv::DMatch>& good_matches,
 	float ratio)
 {
-	unsigned long position = 0;
-	bool insertElement;
+	int boundMatches = 0;
+
 	for (size_t i = 0; i < matches.size(); ++i)
 	{
 		if (matches[i].size() >= 2 && (matches[i][0].distance < ratio * matches[i][1].distance))
 		{
-			position = 0;
-			insertElement = false;
-			if (good_matches.empty()) {
-				good_matches.push_back(matches[i][0]);
-			}
-			else {
-				while (position < good_matches.size() && !insertElement) {
-					if (good_matches.at(position).distance > matches[i][0].distance) {
-						good_matches.insert(good_matches.begin() + position, matches[i][0]);
-						insertElement = true;
-						if (good_matches.size() > this->countMatches) {
-							// Delete last element if maximum is reached
-							good_matches.erase(good_matches.end() - 1);
-						}
-					}
-					position++;
-				}
-				if (!insertElement && good_matches.size() < this->countMatches) {
-					good_matches.push_back(matches[i][0]);
-				}
-			}
+			good_matches.push_back(matches[i][0]);
 
+			// Stop if enough matches are good enough
+			if (this->distanceBound > 0 && matches[i][0].distance <= this->distanceBound && ++boundMatches >= this->countMatches)
+			{
+				break;
+			}
 		}
 	}
 
+	SelectMatches(good_matches);
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::SelectMatches(std::vector<cv::DMatch>& good_matches) const
+{
+
+	if (good_matches.size() > static_cast<size_t>(this->countMatches))
+	{
+		// Partition the best matches to the front, remaining matches are not sorted
+		std::nth_element(good_matches.begin(), good_matches.begin() + this->countMatches, good_matches.end());
+		good_matches.resize(this->countMatches);
+	}
+
+	std::sort(good_matches.begin(), good_matches.end());
 }
 
 void Companion::Algorithm::Recognition::Matching::FeatureMatching::ObtainKeypointsFromGoodMatches(
@@ -365,7 +860,8 @@ void Companion::Algorithm::Recognition::Matching::FeatureMatching::ObtainKeypoin
 	const std::vector<cv::KeyPoint>& keypoints_object,
 	const std::vector<cv::KeyPoint>& keypoints_scene,
 	std::vector<cv::Point2f>& feature_points_object,
-	std::vector<cv::Point2f>& feature_points_scene) {
+	std::vector<cv::Point2f>& feature_points_scene,
+	std::vector<cv::DMatch>& feature_matches) {
 
 	int trainIdx;
 	int queryIdx;
@@ -376,58 +872,190 @@ void Companion::Algorithm::Recognition::Matching::FeatureMatching::ObtainKeypoin
 		trainIdx = good_matches[i].trainIdx;
 		queryIdx = good_matches[i].queryIdx;
 
-		if ((trainIdx > 0 && keypoints_scene.size() > trainIdx) && (queryIdx > 0 && keypoints_object.size() > queryIdx))
+		if ((trainIdx >= 0 && keypoints_scene.size() > trainIdx) && (queryIdx >= 0 && keypoints_object.size() > queryIdx))
 		{
 			feature_points_scene.push_back(keypoints_scene[trainIdx].pt);
 			feature_points_object.push_back(keypoints_object[queryIdx].pt);
+			feature_matches.push_back(good_matches[i]);
+		}
+	}
+
+}
+
+bool Companion::Algorithm::Recognition::Matching::FeatureMatching::GeometricConsistency(const std::vector<cv::DMatch>& good_matches,
+	const std::vector<cv::KeyPoint>& keypoints_object,
+	const std::vector<cv::KeyPoint>& keypoints_scene,
+	std::vector<cv::DMatch>& consistent_matches) const
+{
+	std::vector<int> votes(ROTATION_BINS * SCALE_BINS, 0);
+	std::vector<int> bins(good_matches.size(), -1);
+	bool useRotation = true;
+	int validMatches = 0;
+	int bestVotes = -1;
+	int bestRotation = 0;
+	int bestScale = 0;
+	int neighborVotes;
+	int rotationBin;
+	int scaleBin;
+	float rotation;
+	float scale;
+
+	// Keypoints without orientation like FAST or GFTT vote only for the scale
+	for (const cv::DMatch& match : good_matches)
+	{
+		if (match.queryIdx >= 0 && match.queryIdx < static_cast<int>(keypoints_object.size())
+			&& match.trainIdx >= 0 && match.trainIdx < static_cast<int>(keypoints_scene.size())
+			&& (keypoints_object[match.queryIdx].angle < 0 || keypoints_scene[match.trainIdx].angle < 0))
+		{
+			useRotation = false;
+		}
+	}
+
+	for (size_t i = 0; i < good_matches.size(); i++)
+	{
+		const cv::DMatch& match = good_matches[i];
+
+		if (match.queryIdx < 0 || match.queryIdx >= static_cast<int>(keypoints_object.size())
+			|| match.trainIdx < 0 || match.trainIdx >= static_cast<int>(keypoints_scene.size()))
+		{
+			continue;
+		}
+
+		const cv::KeyPoint& objectKeypoint = keypoints_object[match.queryIdx];
+		const cv::KeyPoint& sceneKeypoint = keypoints_scene[match.trainIdx];
+
+		rotationBin = 0;
+		if (useRotation)
+		{
+			rotation = std::fmod(sceneKeypoint.angle - objectKeypoint.angle + 360.0f, 360.0f);
+			rotationBin = static_cast<int>(rotation * ROTATION_BINS / 360.0f) % ROTATION_BINS;
+		}
+
+		// Scale change in octaves
+		scale = (objectKeypoint.size > 0 && sceneKeypoint.size > 0) ? std::log2(sceneKeypoint.size / objectKeypoint.size) : 0.0f;
+		scaleBin = std::min(std::max(static_cast<int>(std::floor(scale)) + SCALE_BINS / 2, 0), SCALE_BINS - 1);
+
+		bins[i] = scaleBin * ROTATION_BINS + rotationBin;
+		votes[bins[i]]++;
+		validMatches++;
+	}
+
+	// Strongest rotation and scale including the neighbor bins, a peak can be split at bin borders
+	for (int s = 0; s < SCALE_BINS; s++)
+	{
+		for (int r = 0; r < ROTATION_BINS; r++)
+		{
+			neighborVotes = 0;
+			for (int ds = std::max(s - 1, 0); ds <= std::min(s + 1, SCALE_BINS - 1); ds++)
+			{
+				for (int dr = -1; dr <= 1; dr++)
+				{
+					neighborVotes += votes[ds * ROTATION_BINS + (r + dr + ROTATION_BINS) % ROTATION_BINS];
+				}
+			}
+
+			if (neighborVotes > bestVotes)
+			{
+				bestVotes = neighborVotes;
+				bestRotation = r;
+				bestScale = s;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < good_matches.size(); i++)
+	{
+		if (bins[i] < 0)
+		{
+			continue;
+		}
+
+		scaleBin = bins[i] / ROTATION_BINS;
+		rotationBin = bins[i] % ROTATION_BINS;
+
+		// Circular rotation distance
+		if (std::abs(scaleBin - bestScale) <= 1
+			&& std::min((rotationBin - bestRotation + ROTATION_BINS) % ROTATION_BINS, (bestRotation - rotationBin + ROTATION_BINS) % ROTATION_BINS) <= 1)
+		{
+			consistent_matches.push_back(good_matches[i]);
 		}
 	}
 
+	return static_cast<int>(consistent_matches.size()) >= MIN_HOMOGRAPHY_POINTS
+		&& static_cast<float>(consistent_matches.size()) >= MIN_CONSISTENCY * validMatches;
 }
 
 PTR_DRAW Companion::Algorithm::Recognition::Matching::FeatureMatching::ObtainMatchingResult(
-	cv::Mat& sceneImage,
 	cv::Mat& objectImage,
 	std::vector<cv::DMatch>& good_matches,
 	std::vector<cv::KeyPoint>& keypoints_object,
 	std::vector<cv::KeyPoint>& keypoints_scene,
 	PTR_MODEL_FEATURE_MATCHING sModel,
-	PTR_MODEL_FEATURE_MATCHING cModel,
+	PTR_TRACKING_STATE state,
 	bool isIRAUsed,
 	bool isROIUsed,
-	PTR_DRAW_FRAME roi)
+	PTR_DRAW_FRAME roi,
+	int& scoring)
 {
 
 	PTR_DRAW drawable = nullptr;
 	cv::Mat homography;
 	std::vector<cv::Point2f> feature_points_object, feature_points_scene;
+	std::vector<cv::DMatch> consistent_matches;
+	std::vector<cv::DMatch> feature_matches;
+	std::vector<uchar> inliers;
+	cv::Point2f offset;
 
 	feature_points_object.clear();
 	feature_points_scene.clear();
 
 	// Count of good matches if results are good enough.
-	if (good_matches.size() >= this->countMatches)
+	if (good_matches.size() >= static_cast<size_t>(this->countMatches))
 	{
 
-		ObtainKeypointsFromGoodMatches(good_matches,
+		if (this->verificationCascade)
+		{
+			// Reject models whose matches do not agree on rotation and scale before the expensive homography search
+			if (!GeometricConsistency(good_matches, keypoints_object, keypoints_scene, consistent_matches))
+			{
+				return nullptr;
+			}
+		}
+
+		ObtainKeypointsFromGoodMatches(this->verificationCascade ? consistent_matches : good_matches,
 			keypoints_object,
 			keypoints_scene,
 			feature_points_object,
-			feature_points_scene);
+			feature_points_scene,
+			feature_matches);
 
 		// Find Homography if only features points are filled
-		if (!feature_points_object.empty() && !feature_points_scene.empty())
+		if (feature_points_object.size() >= MIN_HOMOGRAPHY_POINTS && feature_points_scene.size() >= MIN_HOMOGRAPHY_POINTS)
 		{
 			homography = cv::findHomography(feature_points_object,
 				feature_points_scene,
 				this->findHomographyMethod,
 				this->reprojThreshold,
-				cv::noArray(),
+				inliers,
 				this->ransacMaxIters);
 
 			if (!homography.empty())
 			{
-				drawable = CalculateArea(homography, sceneImage, objectImage, sModel, cModel, isIRAUsed, isROIUsed, roi);
+				scoring = Scoring(feature_matches, feature_points_object, feature_points_scene, inliers, homography);
+			}
+
+			// Results below the minimum scoring are cut before IRA stores their position
+			if (!homography.empty() && scoring >= this->minScoring)
+			{
+				// Offset is taken before IRA stores the new position
+				offset = SearchOffset(state, isIRAUsed, isROIUsed, roi);
+				drawable = CalculateArea(homography, objectImage, sModel, state, isIRAUsed, isROIUsed, roi, true);
+
+				if (drawable != nullptr && state != nullptr && this->trackingInterval > 0 && !this->cudaUsed)
+				{
+					// Following frames track the object with its inliers
+					StartTrack(feature_points_object, feature_points_scene, inliers, homography, offset, sModel, state, scoring);
+				}
 			}
 		}
 
@@ -436,15 +1064,285 @@ PTR_DRAW Companion::Algorithm::Recognition::Matching::FeatureMatching::ObtainMat
 	return drawable;
 }
 
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::MatchInstances(cv::Mat descriptorsObject,
+	cv::Mat descriptorsScene,
+	std::vector<cv::DMatch>& good_matches)
+{
+	std::vector<std::vector<cv::DMatch>> matches;
+	std::vector<cv::DMatch> sceneMatches;
+
+	// Scene descriptors are the query, object descriptors of repeated instances would fail the ratio test otherwise
+	if (matcherType == cv::DescriptorMatcher::BRUTEFORCE_HAMMING && HammingMatcher::IsSupported(descriptorsScene, descriptorsObject))
+	{
+		HammingMatcher::Match(descriptorsScene, descriptorsObject, this->ratio, sceneMatches);
+	}
+	else
+	{
+		// If matching type is flan based, scene and object must be in CV_32F format
+		if (matcherType == cv::DescriptorMatcher::FLANNBASED && descriptorsScene.type() != CV_32F)
+		{
+			descriptorsScene.convertTo(descriptorsScene, CV_32F);
+		}
+		if (matcherType == cv::DescriptorMatcher::FLANNBASED && descriptorsObject.type() != CV_32F)
+		{
+			descriptorsObject.convertTo(descriptorsObject, CV_32F);
+		}
+
+		matcher->knnMatch(descriptorsScene, descriptorsObject, matches, DEFAULT_NEIGHBOR);
+
+		// Ratio test for good matches - http://www.cs.ubc.ca/~lowe/papers/ijcv04.pdf#page=20
+		for (size_t i = 0; i < matches.size(); i++)
+		{
+			if (matches[i].size() >= 2 && (matches[i][0].distance < this->ratio * matches[i][1].distance))
+			{
+				sceneMatches.push_back(matches[i][0]);
+			}
+		}
+	}
+
+	// Object keypoint is query and scene keypoint is train like single instance matches
+	for (const cv::DMatch& match : sceneMatches)
+	{
+		good_matches.push_back(cv::DMatch(match.trainIdx, match.queryIdx, match.distance));
+	}
+
+	// All matches are kept for all instances, ordered by distance for PROSAC
+	std::sort(good_matches.begin(), good_matches.end());
+}
+
+bool Companion::Algorithm::Recognition::Matching::FeatureMatching::ObtainInstance(cv::Mat& objectImage,
+	std::vector<cv::DMatch>& good_matches,
+	std::vector<cv::KeyPoint>& keypoints_object,
+	std::vector<cv::KeyPoint>& keypoints_scene,
+	PTR_MODEL_FEATURE_MATCHING sModel,
+	bool isROIUsed,
+	PTR_DRAW_FRAME roi,
+	PTR_DRAW& drawable,
+	int& scoring)
+{
+	std::vector<cv::DMatch> consistent_matches;
+	std::vector<cv::DMatch> remaining_matches;
+	std::vector<cv::DMatch> feature_matches;
+	std::vector<cv::Point2f> feature_points_object, feature_points_scene;
+	std::vector<cv::Point2f> object_corners(4);
+	std::vector<cv::Point2f> scene_corners(4);
+	std::vector<uchar> inliers;
+	std::vector<bool> removedScene(keypoints_scene.size(), false);
+	const std::vector<cv::DMatch>* candidates = &good_matches;
+	int inlierCount = 0;
+	cv::Mat homography;
+
+	drawable = nullptr;
+
+	if (this->verificationCascade)
+	{
+		// Remaining matches of all instances must share a rotation and scale
+		if (!GeometricConsistency(good_matches, keypoints_object, keypoints_scene, consistent_matches))
+		{
+			return false;
+		}
+
+		candidates = &consistent_matches;
+	}
+
+	ObtainKeypointsFromGoodMatches(*candidates,
+		keypoints_object,
+		keypoints_scene,
+		feature_points_object,
+		feature_points_scene,
+		feature_matches);
+
+	if (feature_points_object.size() < MIN_HOMOGRAPHY_POINTS)
+	{
+		return false;
+	}
+
+	homography = cv::findHomography(feature_points_object,
+		feature_points_scene,
+		this->findHomographyMethod,
+		this->reprojThreshold,
+		inliers,
+		this->ransacMaxIters);
+
+	for (size_t i = 0; i < inliers.size(); i++)
+	{
+		if (inliers[i])
+		{
+			removedScene[feature_matches[i].trainIdx] = true;
+			inlierCount++;
+		}
+	}
+
+	if (homography.empty() || inlierCount < MIN_INSTANCE_INLIERS)
+	{
+		return false;
+	}
+
+	// Instances below the minimum scoring are removed without a result
+	scoring = Scoring(feature_matches, feature_points_object, feature_points_scene, inliers, homography);
+	if (scoring >= this->minScoring)
+	{
+		drawable = CalculateArea(homography, objectImage, sModel, nullptr, false, isROIUsed, roi, false);
+	}
+
+	// Matches inside the found instance belong to it even if they are no inliers
+	object_corners[0] = cv::Point2f(0, 0);
+	object_corners[1] = cv::Point2f(objectImage.cols, 0);
+	object_corners[2] = cv::Point2f(objectImage.cols, objectImage.rows);
+	object_corners[3] = cv::Point2f(0, objectImage.rows);
+	cv::perspectiveTransform(object_corners, scene_corners, homography);
+
+	for (const cv::DMatch& match : good_matches)
+	{
+		if (!removedScene[match.trainIdx] && cv::pointPolygonTest(scene_corners, keypoints_scene[match.trainIdx].pt, false) < 0)
+		{
+			remaining_matches.push_back(match);
+		}
+	}
+
+	good_matches.swap(remaining_matches);
+	return true;
+}
+
+int Companion::Algorithm::Recognition::Matching::FeatureMatching::Scoring(const std::vector<cv::DMatch>& feature_matches,
+	const std::vector<cv::Point2f>& feature_points_object,
+	const std::vector<cv::Point2f>& feature_points_scene,
+	const std::vector<uchar>& inliers,
+	const cv::Mat& homography) const
+{
+	std::vector<cv::Point2f> projected_points;
+	std::vector<float> distances;
+	float medianDistance;
+	float reprojectionError = 0.0f;
+	int inlierCount = 0;
+	int bestMatches = 0;
+	int bestInliers = 0;
+	float inlierRatio;
+	float inlierSupport;
+	float reprojectionQuality;
+	float distanceQuality;
+
+	if (feature_matches.empty() || homography.empty())
+	{
+		return 0;
+	}
+
+	cv::perspectiveTransform(feature_points_object, projected_points, homography);
+
+	for (size_t i = 0; i < feature_matches.size(); i++)
+	{
+		// Methods without a mask use all points
+		if (inliers.empty() || inliers[i])
+		{
+			reprojectionError += static_cast<float>(cv::norm(projected_points[i] - feature_points_scene[i]));
+			inlierCount++;
+		}
+		distances.push_back(feature_matches[i].distance);
+	}
+
+	if (inlierCount == 0)
+	{
+		return 0;
+	}
+
+	// Inliers of a recognized object are the closest matches, so the best half of all matches should be inliers
+	std::nth_element(distances.begin(), distances.begin() + distances.size() / 2, distances.end());
+	medianDistance = distances[distances.size() / 2];
+	for (size_t i = 0; i < feature_matches.size(); i++)
+	{
+		if (feature_matches[i].distance <= medianDistance)
+		{
+			bestMatches++;
+			if (inliers.empty() || inliers[i])
+			{
+				bestInliers++;
+			}
+		}
+	}
+
+	inlierRatio = static_cast<float>(inlierCount) / feature_matches.size();
+	inlierSupport = std::min(1.0f, static_cast<float>(inlierCount) / this->countMatches);
+	reprojectionQuality = std::max(0.0f, 1.0f - (reprojectionError / inlierCount) / static_cast<float>(std::max(this->reprojThreshold, 1.0)));
+	distanceQuality = static_cast<float>(bestInliers) / std::max(1, bestMatches);
+
+	return static_cast<int>(std::round(100.0f * (SCORING_INLIER_RATIO * inlierRatio
+		+ SCORING_INLIER_SUPPORT * inlierSupport
+		+ SCORING_REPROJECTION * reprojectionQuality
+		+ SCORING_DISTANCE * distanceQuality)));
+}
+
+int Companion::Algorithm::Recognition::Matching::FeatureMatching::MinScoring() const
+{
+	return this->minScoring;
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::MinScoring(int minScoring)
+{
+	this->minScoring = std::min(std::max(minScoring, 0), 100);
+}
+
+cv::Point2f Companion::Algorithm::Recognition::Matching::FeatureMatching::SearchOffset(PTR_TRACKING_STATE state,
+	bool isIRAUsed,
+	bool isROIUsed,
+	PTR_DRAW_FRAME roi) const
+{
+	cv::Rect lastRect = cv::Rect();
+
+	if (isIRAUsed) // IRA was used
+	{
+		lastRect = state->Ira()->LastObjectPosition();
+	}
+	else if (isROIUsed)
+	{
+		lastRect = cv::Rect(roi->TopLeft(), roi->BottomRight());
+	}
+
+	return cv::Point2f(lastRect.x, lastRect.y);
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::StartTrack(const std::vector<cv::Point2f>& feature_points_object,
+	const std::vector<cv::Point2f>& feature_points_scene,
+	const std::vector<uchar>& inliers,
+	const cv::Mat& homography,
+	cv::Point2f offset,
+	PTR_MODEL_FEATURE_MATCHING sModel,
+	PTR_TRACKING_STATE state,
+	int scoring)
+{
+	std::vector<cv::Point2f> objectPoints;
+	std::vector<cv::Point2f> scenePoints;
+	cv::Mat translation = cv::Mat::eye(3, 3, CV_64F);
+
+	for (size_t i = 0; i < inliers.size() && i < feature_points_scene.size(); i++)
+	{
+		if (inliers[i])
+		{
+			objectPoints.push_back(feature_points_object[i]);
+			scenePoints.push_back(feature_points_scene[i] + offset);
+		}
+	}
+
+	if (static_cast<int>(objectPoints.size()) < MIN_TRACK_POINTS)
+	{
+		state->Track()->Clear();
+		return;
+	}
+
+	// Homography of the searched area is moved to the full scene image
+	translation.at<double>(0, 2) = offset.x;
+	translation.at<double>(1, 2) = offset.y;
+	state->Track()->Start(objectPoints, scenePoints, translation * homography, sModel->Image(), scoring);
+}
+
 PTR_DRAW Companion::Algorithm::Recognition::Matching::FeatureMatching::CalculateArea(
 	cv::Mat& homography,
-	cv::Mat& sceneImage,
 	cv::Mat& objectImage,
 	PTR_MODEL_FEATURE_MATCHING sModel,
-	PTR_MODEL_FEATURE_MATCHING cModel,
+	PTR_TRACKING_STATE state,
 	bool isIRAUsed,
 	bool isROIUsed,
-	PTR_DRAW_FRAME roi)
+	PTR_DRAW_FRAME roi,
+	bool updateIRA)
 {
 
 	PTR_DRAW_FRAME frame = nullptr;
@@ -461,20 +1359,8 @@ PTR_DRAW Companion::Algorithm::Recognition::Matching::FeatureMatching::Calculate
 	cv::perspectiveTransform(obj_corners, scene_corners, homography);
 
 	//-- Draw lines between the corners (the mapped object in the scene - image_2 )
-	cv::Rect lastRect = cv::Rect();
-	PTR_IMAGE_REDUCTION_ALGORITHM ira = cModel->Ira();
-
-	if (isIRAUsed) // IRA was used
-	{
-		lastRect = ira->LastObjectPosition();
-	}
-	else if (isROIUsed)
-	{
-		lastRect = cv::Rect(roi->TopLeft(), roi->BottomRight());
-	}
-
 	// Offset is recalculate position from last recognition if exists
-	cv::Point2f offset = cv::Point2f(lastRect.x, lastRect.y);
+	cv::Point2f offset = SearchOffset(state, isIRAUsed, isROIUsed, roi);
 
 	// Focus area - Scene Corners
 	//   0               1
@@ -486,26 +1372,6 @@ PTR_DRAW Companion::Algorithm::Recognition::Matching::FeatureMatching::Calculate
 	//   -----------------
 	//   3               2
 
-	float minX = sceneImage.cols;
-	float maxX = 0.0f;
-	float minY = sceneImage.rows;
-	float maxY = 0.0f;
-
-	for (cv::Point2f point : scene_corners)
-	{
-		if (point.x < minX) { minX = point.x; }
-		if (point.x > maxX) { maxX = point.x; }
-		if (point.y < minY) { minY = point.y; }
-		if (point.y > maxY) { maxY = point.y; }
-	}
-
-	float width = maxX - minX;
-	float height = maxY - minY;
-
-	cv::Point2f scale = cv::Point2f(width / 2.0f, height / 2.0f);
-	cv::Point2f start = cv::Point2f(minX, minY) + offset - scale;
-	cv::Point2f end = cv::Point2f(maxX, maxY) + offset + scale;
-
 	// Object area
 	cv::Point2f topLeft = scene_corners[0] + offset;
 	cv::Point2f topRight = scene_corners[1] + offset;
@@ -520,47 +1386,51 @@ PTR_DRAW Companion::Algorithm::Recognition::Matching::FeatureMatching::Calculate
 	}
 
 	// If IRA is used...
-	if (useIRA && frame != nullptr)
+	if (useIRA && updateIRA && frame != nullptr && state != nullptr)
 	{
 
-		// IRA stores position from the recognized object
-		ira->LastObjectPosition(start.x, start.y, end.x - start.x, end.y - start.y);
-		const cv::Rect& lastObjectPosition = ira->LastObjectPosition();
-
-		// Check if start point is set correctly
-		if (lastObjectPosition.x < 0)
-		{
-			ira->X(0);
-		}
-
-		// Check if width is not oversized
-		if (lastObjectPosition.width + lastObjectPosition.x > originalImg.cols)
-		{
-			ira->Width(originalImg.cols - lastObjectPosition.x);
-		}
-
-		if (lastObjectPosition.y < 0) {
-			ira->Y(0);
-		}
-
-		if (lastObjectPosition.height + lastObjectPosition.y > originalImg.rows)
-		{
-			ira->Height(originalImg.rows - lastObjectPosition.y);
-		}
+		// IRA stores the search area around the recognized object
+		cv::Rect lastObjectPosition = IRA::SearchArea({ topLeft, topRight, bottomRight, bottomLeft }, originalImg.size());
+		state->Ira()->LastObjectPosition(lastObjectPosition.x, lastObjectPosition.y, lastObjectPosition.width, lastObjectPosition.height);
 
 		if (lastObjectPosition.area() <= 0)
 		{
 			// Something goes wrong in area clear IRA
-			ira->Clear();
+			state->Ira()->Clear();
 		}
 	}
 
 	return frame;
 }
 
+bool Companion::Algorithm::Recognition::Matching::FeatureMatching::VerificationCascade() const
+{
+	return this->verificationCascade;
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::VerificationCascade(bool verificationCascade)
+{
+	this->verificationCascade = verificationCascade;
+}
+
 void Companion::Algorithm::Recognition::Matching::FeatureMatching::UseIRA(bool useIRA)
 {
 	this->useIRA = useIRA;
 }
 
 
+PTR_FEATURE_CACHE Companion::Algorithm::Recognition::Matching::FeatureMatching::FeatureCache() const
+{
+	return this->featureCache;
+}
+
+void Companion::Algorithm::Recognition::Matching::FeatureMatching::FeatureCache(PTR_FEATURE_CACHE featureCache, const std::string& parametersTag)
+{
+	this->featureCache = featureCache;
+
+	if (this->featureCache != nullptr && !this->cudaUsed)
+	{
+		// Detector and extractor do not change, so the key is calculated once
+		this->featureCacheKey = Model::Processing::FeatureCache::ParametersKey(this->detector, this->extractor, parametersTag);
+	}
+}
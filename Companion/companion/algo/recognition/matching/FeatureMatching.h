@@ -19,8 +19,16 @@
 #ifndef COMPANION_FEATUREMATCHING_H
 #define COMPANION_FEATUREMATCHING_H
 
+#include <algorithm>
+#include <cmath>
+#include <opencv2/video/tracking.hpp>
 #include <companion/algo/recognition/matching/Matching.h>
 #include <companion/algo/recognition/matching/util/IRA.h>
+#include <companion/algo/recognition/matching/util/ObjectTrack.h>
+#include <companion/algo/recognition/matching/util/TrackingState.h>
+#include <companion/algo/recognition/matching/util/DescriptorIndex.h>
+#include <companion/algo/recognition/matching/util/HammingMatcher.h>
+#include <companion/model/processing/FeatureCache.h>
 #include <companion/util/CompanionError.h>
 
 namespace Companion {
@@ -118,13 +126,22 @@ namespace Companion {
 					virtual ~FeatureMatching() = default;
 
 					/**
-					 * Calculate key points for given model.
+					 * Calculate key points and descriptors for given scene model on its grayscale image. Calculated scene
+					 * features are shared by all models and regions of ExecuteAlgorithm(), so they are calculated once per frame.
 					 * @param model Model to calculate keypoints.
 					 */
 					void CalculateKeyPoints(PTR_MODEL_FEATURE_MATCHING model);
 
+					/**
+					 * Prepare an object model for matching by loading its keypoints and descriptors from the feature cache
+					 * or by calculating them. Models which are already prepared are not changed. Not used for cuda.
+					 * @param objectModel Object model to prepare.
+					 */
+					void PrepareModel(PTR_MODEL_FEATURE_MATCHING objectModel);
+
 					/**
 					 * Feature matching algorithm implementation to search in a scene model for the given object model.
+					 * IRA is not used because no tracking state is given.
 					 * @param sceneModel Scene model to verify for matching.
 					 * @param objectModel Object model to search in scene.
 					 * @param roi A region of interest where to search for the object (not used if nullptr).
@@ -134,18 +151,232 @@ namespace Companion {
 						PTR_MODEL_FEATURE_MATCHING objectModel,
 						PTR_DRAW_FRAME roi);
 
+					/**
+					 * Feature matching algorithm implementation to search in a scene model for the given object model.
+					 * If a region of interest is given only this region is searched. Otherwise the object is searched in
+					 * the IRA area of the last recognition first and then in the full scene, scene features are obtained
+					 * once and reused by both steps.
+					 * @param sceneModel Scene model to verify for matching.
+					 * @param objectModel Object model to search in scene.
+					 * @param roi A region of interest where to search for the object (not used if nullptr).
+					 * @param state Tracking state of the object model in the stream of the scene, IRA and tracking are
+					 * not used if nullptr.
+					 * @return A recognition result model if an object is recognized, otherwise nullptr.
+					 */
+					PTR_RESULT_RECOGNITION ExecuteAlgorithm(PTR_MODEL_FEATURE_MATCHING sceneModel,
+						PTR_MODEL_FEATURE_MATCHING objectModel,
+						PTR_DRAW_FRAME roi,
+						PTR_TRACKING_STATE state);
+
+					/**
+					 * Search the object model only in the IRA area of its last recognition, for example before the regions
+					 * of interest of a frame are searched. The IRA position is cleared if the object is not found.
+					 * @param sceneModel Scene model to verify for matching.
+					 * @param objectModel Object model to search in scene.
+					 * @param state Tracking state of the object model in the stream of the scene.
+					 * @return A recognition result model if an object is recognized, otherwise nullptr. Always nullptr if
+					 * IRA is not used, cuda is used or no IRA position is stored.
+					 */
+					PTR_RESULT_RECOGNITION SearchIRA(PTR_MODEL_FEATURE_MATCHING sceneModel,
+						PTR_MODEL_FEATURE_MATCHING objectModel,
+						PTR_TRACKING_STATE state);
+
+					/**
+					 * Feature matching algorithm implementation to search all instances of the given object model in a
+					 * scene model, for example the same product on a shelf. Scene keypoints are matched against the object
+					 * keypoints so that each instance obtains its own matches. Instances are found one after another by
+					 * finding a homography and removing its inliers and all matches inside the recognized instance.
+					 * If only one instance is searched or cuda is used ExecuteAlgorithm() is used with the given tracking
+					 * state, otherwise IRA is not used.
+					 * @param sceneModel Scene model to verify for matching.
+					 * @param objectModel Object model to search in scene.
+					 * @param roi A region of interest where to search for the object (not used if nullptr).
+					 * @param state Tracking state of the object model in the stream of the scene (not used if nullptr).
+					 * @return Recognition result models of all recognized instances, empty if no object is recognized.
+					 */
+					std::vector<PTR_RESULT_RECOGNITION> FindInstances(PTR_MODEL_FEATURE_MATCHING sceneModel,
+						PTR_MODEL_FEATURE_MATCHING objectModel,
+						PTR_DRAW_FRAME roi,
+						PTR_TRACKING_STATE state);
+
+					/**
+					 * Search candidates of the given object model in a scene model like FindInstances() without ROI, but
+					 * IRA is never used or changed, for example to search objects in a downscaled scene. At most
+					 * MaxInstances() candidates are returned. Not used for cuda.
+					 * @param sceneModel Scene model to verify for matching.
+					 * @param objectModel Object model to search in scene.
+					 * @return Recognition result models of all candidates, empty if no candidate is found.
+					 */
+					std::vector<PTR_RESULT_RECOGNITION> FindCandidates(PTR_MODEL_FEATURE_MATCHING sceneModel,
+						PTR_MODEL_FEATURE_MATCHING objectModel);
+
+					/**
+					 * Follow a recognized object from the last frame into the given frame with sparse optical flow on the
+					 * homography inliers of its recognition, so that no features are detected and matched. The track is
+					 * cleared if too few points are followed or TrackingInterval() frames are tracked, the object must
+					 * then be recognized by feature matching again. Tracks are started by single instance recognitions
+					 * if a tracking interval is set. Not used for cuda.
+					 * @param sceneGray Grayscale image of the frame, in the size of the scene model images.
+					 * @param objectModel Object model to follow.
+					 * @param state Tracking state of the object model in the stream of the frame.
+					 * @return A recognition result model if the object is followed, otherwise nullptr.
+					 */
+					PTR_RESULT_RECOGNITION TrackObject(const cv::Mat& sceneGray,
+						PTR_MODEL_FEATURE_MATCHING objectModel,
+						PTR_TRACKING_STATE state);
+
+					/**
+					 * Create a descriptor index over the given object models to match a scene once against all models.
+					 * Models are prepared if their keypoints and descriptors are not calculated yet. Not used for cuda.
+					 * @param objectModels Object models to index.
+					 * @return Descriptor index of all object models.
+					 */
+					PTR_DESCRIPTOR_INDEX CreateIndex(const std::vector<PTR_MODEL_FEATURE_MATCHING>& objectModels);
+
+					/**
+					 * Match the calculated scene descriptors against a descriptor index.
+					 * @param index Descriptor index of the object models.
+					 * @param sceneModel Scene model with calculated keypoints and descriptors.
+					 * @param modelMatches Good matches of each indexed model, in the order of the index models.
+					 */
+					void MatchIndex(PTR_DESCRIPTOR_INDEX index,
+						PTR_MODEL_FEATURE_MATCHING sceneModel,
+						std::vector<std::vector<cv::DMatch>>& modelMatches);
+
+					/**
+					 * Verify good matches between an object model and the full scene, for example matches from a
+					 * descriptor index, by finding the homography of the object.
+					 * @param sceneModel Scene model with calculated keypoints.
+					 * @param objectModel Object model with calculated keypoints.
+					 * @param goodMatches Good matches with object keypoints as query and scene keypoints as train index.
+					 * @return A recognition result model if an object is recognized, otherwise nullptr.
+					 */
+					PTR_RESULT_RECOGNITION VerifyMatches(PTR_MODEL_FEATURE_MATCHING sceneModel,
+						PTR_MODEL_FEATURE_MATCHING objectModel,
+						std::vector<cv::DMatch> goodMatches);
+
+					/**
+					 * Get number of good matches which are needed to verify an object.
+					 * @return Number of needed good matches.
+					 */
+					int CountMatches() const;
+
+					/**
+					 * Set number of good matches which are needed to verify an object. Only the best good matches up to
+					 * this number are used to find the homography.
+					 * @param countMatches Number of needed good matches. If countMatches <= 0 40 matches are used.
+					 */
+					void CountMatches(int countMatches);
+
+					/**
+					 * Get ratio of the ratio test.
+					 * @return Ratio to determine which matches are good enough. Default is 0.8.
+					 */
+					float Ratio() const;
+
+					/**
+					 * Set ratio of the ratio test, a lower ratio keeps fewer but more distinctive matches.
+					 * @param ratio Ratio to determine which matches are good enough. If ratio is not in (0, 1] 0.8 is used.
+					 */
+					void Ratio(float ratio);
+
+					/**
+					 * Get distance bound for the early exit of the match selection.
+					 * @return Distance bound, 0 if all matches are compared.
+					 */
+					float DistanceBound() const;
+
+					/**
+					 * Set distance bound for the early exit of the match selection. Matching stops as soon as the number of
+					 * needed good matches has a distance below or equal to this bound, so not all scene matches are compared
+					 * in dense scenes. The bound depends on the descriptor, for example the hamming distance of binary descriptors.
+					 * @param distanceBound Distance bound. If distanceBound <= 0 all matches are compared.
+					 */
+					void DistanceBound(float distanceBound);
+
 					/**
 					 * Indicator if this algorithm uses cuda.
 					 * @return True if cuda will be used otherwise false.
 					 */
 					bool IsCuda() const;
 
+					/**
+					 * Indicator if the verification cascade is used.
+					 * @return True if the verification cascade is used otherwise false.
+					 */
+					bool VerificationCascade() const;
+
+					/**
+					 * Set to disable or enable the verification cascade. Good matches are first checked for a consistent
+					 * rotation and scale between object and scene keypoints, so that obviously wrong models are rejected
+					 * before the homography is searched. Only the consistent matches are used for the homography, with
+					 * cv::RHO as homography method they are sampled in the order of their distance like PROSAC.
+					 * Disabled by default.
+					 * @param verificationCascade Use the verification cascade.
+					 */
+					void VerificationCascade(bool verificationCascade);
+
 					/**
 					 * Set to disable or enable IRA function.
 					 * @param useIRA Use IRA algorithm to store last recognized object from frame.
 					 */
 					void UseIRA(bool useIRA);
 
+					/**
+					 * Get minimum scoring of a result.
+					 * @return Minimum scoring between 0 and 100, results with a lower scoring are not returned. Default is 0.
+					 */
+					int MinScoring() const;
+
+					/**
+					 * Set minimum scoring of a result. The scoring of a result is calculated from the number and ratio of
+					 * homography inliers, their reprojection error and the share of inliers in the closest matches.
+					 * @param minScoring Minimum scoring between 0 and 100, results with a lower scoring are not returned.
+					 */
+					void MinScoring(int minScoring);
+
+					/**
+					 * Get number of frames an object is tracked before it is recognized by feature matching again.
+					 * @return Tracking interval, 0 if objects are not tracked. Default is 0.
+					 */
+					int TrackingInterval() const;
+
+					/**
+					 * Set number of frames an object is tracked by TrackObject() before it is recognized by feature
+					 * matching again.
+					 * @param trackingInterval Tracking interval. If trackingInterval <= 0 objects are not tracked.
+					 */
+					void TrackingInterval(int trackingInterval);
+
+					/**
+					 * Get maximum number of instances of an object which are searched by FindInstances().
+					 * @return Maximum number of instances. Default is one instance.
+					 */
+					int MaxInstances() const;
+
+					/**
+					 * Set maximum number of instances of an object which are searched by FindInstances().
+					 * @param maxInstances Maximum number of instances. If maxInstances <= 0 one instance is searched.
+					 */
+					void MaxInstances(int maxInstances);
+
+					/**
+					 * Get feature cache if set.
+					 * @return Feature cache of object models or nullptr if no cache is used.
+					 */
+					PTR_FEATURE_CACHE FeatureCache() const;
+
+					/**
+					 * Set a feature cache to load object model keypoints and descriptors instead of calculating them.
+					 * Calculated keypoints and descriptors are stored to the cache, call FeatureCache::Save() to persist them.
+					 * Not used for cuda based feature matching.
+					 * @param featureCache Feature cache to use or nullptr to calculate all object models.
+					 * @param parametersTag Parameters or version of the detector and extractor which is added to the cache
+					 * key. Required if the detector or extractor does not serialize its parameters like ORB, otherwise
+					 * changed parameters load stale keypoints. See FeatureCache::ParametersKey().
+					 */
+					void FeatureCache(PTR_FEATURE_CACHE featureCache, const std::string& parametersTag = "");
+
 				private:
 
 					/**
@@ -158,6 +389,71 @@ namespace Companion {
 					 */
 					static constexpr float DEFAULT_RATIO_VALUE = 0.8f;
 
+					/**
+					 * Number of rotation bins of the geometric consistency check, 10 degrees per bin.
+					 */
+					static constexpr int ROTATION_BINS = 36;
+
+					/**
+					 * Number of scale bins of the geometric consistency check, one octave per bin.
+					 */
+					static constexpr int SCALE_BINS = 10;
+
+					/**
+					 * Minimum ratio of good matches which must have a consistent rotation and scale.
+					 */
+					static constexpr float MIN_CONSISTENCY = 0.25f;
+
+					/**
+					 * Minimum number of point pairs to find a homography.
+					 */
+					static constexpr int MIN_HOMOGRAPHY_POINTS = 4;
+
+					/**
+					 * Minimum number of homography inliers of an object instance.
+					 */
+					static constexpr int MIN_INSTANCE_INLIERS = 10;
+
+					/**
+					 * Scoring weight of the ratio of homography inliers to all used matches.
+					 */
+					static constexpr float SCORING_INLIER_RATIO = 0.35f;
+
+					/**
+					 * Scoring weight of the number of inliers compared to the number of needed good matches.
+					 */
+					static constexpr float SCORING_INLIER_SUPPORT = 0.25f;
+
+					/**
+					 * Scoring weight of the mean reprojection error of the inliers.
+					 */
+					static constexpr float SCORING_REPROJECTION = 0.2f;
+
+					/**
+					 * Scoring weight of the share of inliers in the closer half of all used matches.
+					 */
+					static constexpr float SCORING_DISTANCE = 0.2f;
+
+					/**
+					 * Minimum number of points to follow a tracked object.
+					 */
+					static constexpr int MIN_TRACK_POINTS = 10;
+
+					/**
+					 * Minimum ratio of followed points to the points of the recognition which started the track.
+					 */
+					static constexpr float MIN_TRACK_QUALITY = 0.5f;
+
+					/**
+					 * Window size of the optical flow search on each pyramid level.
+					 */
+					static constexpr int TRACK_WINDOW = 21;
+
+					/**
+					 * Maximum pyramid level of the optical flow search.
+					 */
+					static constexpr int TRACK_LEVELS = 3;
+
 					/**
 					 * Minimum length of the recognized area's sides (in pixels). Default value is 10.
 					 */
@@ -168,11 +464,41 @@ namespace Companion {
 					 */
 					int countMatches = 40;
 
+					/**
+					 * Ratio test value to obtain only good feature matches. Default value is 0.8.
+					 */
+					float ratio = DEFAULT_RATIO_VALUE;
+
+					/**
+					 * Distance bound for the early exit of the match selection, 0 if not used.
+					 */
+					float distanceBound = 0.0f;
+
 					/**
 					 * Indicator to used IRA algorithm.
 					 */
 					bool useIRA = false;
 
+					/**
+					 * Indicator to use the verification cascade before the homography is searched.
+					 */
+					bool verificationCascade = false;
+
+					/**
+					 * Maximum number of instances of an object which are searched by FindInstances().
+					 */
+					int maxInstances = 1;
+
+					/**
+					 * Minimum scoring of a result between 0 and 100.
+					 */
+					int minScoring = 0;
+
+					/**
+					 * Number of frames an object is tracked before it is recognized again, 0 if objects are not tracked.
+					 */
+					int trackingInterval = 0;
+
 					/**
 					 * Homography parameter: Method used to compute a homography matrix. The following methods are possible:
 					 *      - 0      (a regular method using all the points)
@@ -219,6 +545,16 @@ namespace Companion {
 					 */
 					cv::Ptr<cv::DescriptorMatcher> matcher;
 
+					/**
+					 * Feature cache of object models.
+					 */
+					PTR_FEATURE_CACHE featureCache;
+
+					/**
+					 * Key of the detector and extractor parameters in the feature cache.
+					 */
+					uint64_t featureCacheKey = 0;
+
 #if Companion_USE_CUDA
 					/**
 					 * Cuda feature matching algorithm.
@@ -234,25 +570,94 @@ namespace Companion {
 #endif
 
 					/**
-					 * Repeat algorithm method if IRA or ROI do not return results.
+					 * Detect keypoints and calculate descriptors on the grayscale version of the given image.
+					 * @param image Image to calculate features from.
+					 * @param keypoints Detected keypoints.
+					 * @param descriptors Calculated descriptors.
+					 */
+					void DetectAndCompute(const cv::Mat& image,
+						std::vector<cv::KeyPoint>& keypoints,
+						cv::Mat& descriptors);
+
+					/**
+					 * Obtain the scene keypoints and descriptors of the full scene or of a searched area. Features which are
+					 * calculated once for the scene model are reused, otherwise they are detected in the searched area.
+					 * @param sceneModel Scene model.
+					 * @param searchArea Searched area, clipped to the scene image.
+					 * @param isAreaUsed Indicator if only the searched area is used.
+					 * @param keypoints Keypoints of the scene, relative to the searched area if used.
+					 * @param descriptors Descriptors of the scene keypoints.
+					 */
+					void SceneFeatures(PTR_MODEL_FEATURE_MATCHING sceneModel,
+						const cv::Rect& searchArea,
+						bool isAreaUsed,
+						std::vector<cv::KeyPoint>& keypoints,
+						cv::Mat& descriptors);
+
+					/**
+					 * Select the keypoints and descriptors inside an area. Selected keypoints are moved into the coordinate
+					 * system of the area like keypoints which are detected on the cut out area.
+					 * @param keypoints Keypoints of the full image.
+					 * @param descriptors Descriptors of the full image.
+					 * @param area Area to select.
+					 * @param areaKeypoints Keypoints inside the area.
+					 * @param areaDescriptors Descriptors of the keypoints inside the area.
+					 */
+					void FilterKeypoints(const std::vector<cv::KeyPoint>& keypoints,
+						const cv::Mat& descriptors,
+						const cv::Rect& area,
+						std::vector<cv::KeyPoint>& areaKeypoints,
+						cv::Mat& areaDescriptors);
+
+					/**
+					 * Search the object model in the IRA area, in the region of interest and in the full scene, the first
+					 * recognition is returned.
+					 * @param sceneModel Scene model to verify for matching.
+					 * @param objectModel Object model to search in scene.
+					 * @param roi Region of interest to search, if nullptr the IRA area and the full scene are searched.
+					 * @param state Tracking state of the object model (IRA and tracking are not used if nullptr).
+					 * @param searchScene Search the full scene if the object is not found in the IRA area.
+					 * @return A recognition result model if an object is recognized, otherwise nullptr.
+					 */
+					PTR_RESULT_RECOGNITION Search(PTR_MODEL_FEATURE_MATCHING sceneModel,
+						PTR_MODEL_FEATURE_MATCHING objectModel,
+						PTR_DRAW_FRAME roi,
+						PTR_TRACKING_STATE state,
+						bool searchScene);
+
+					/**
+					 * Match the object model in one search step of ExecuteAlgorithm(), which searches the IRA area, the
+					 * region of interest or the full scene. Only the first step detects scene features in its area, a
+					 * repeated step detects the full scene once and selects the features of its area.
 					 * @param sceneModel Scene model to check.
-					 * @param objectModel Object model to search.
+					 * @param objectModel Prepared object model to search.
+					 * @param state Tracking state which stores the last position data.
 					 * @param roi Region of interest object to check (not used if nullptr).
-					 * @param isIRAUsed Checks if IRA was used in last iteration.
-					 * @param ira IRA model to store last position data.
-					 * @param isROIUsed Check if region of interests was used in last search iteration.
-					 * @return Recognition result (nullptr if no object is recognized).
+					 * @param isIRAUsed Search in the IRA area of the tracking state.
+					 * @param isROIUsed Search in the region of interest.
+					 * @param isRepeated Indicator if a previous search step was not successful.
+					 * @param sceneKeypoints Keypoints of the full scene, shared between the search steps.
+					 * @param sceneDescriptors Descriptors of the full scene, shared between the search steps.
+					 * @param isSceneDetected Indicator if the full scene features are obtained.
+					 * @param scoring Scoring of the recognition.
+					 * @return Drawable of the recognized object (nullptr if no object is recognized).
 					 */
-					PTR_RESULT_RECOGNITION RepeatAlgorithm(PTR_MODEL_FEATURE_MATCHING sceneModel,
+					PTR_DRAW MatchArea(PTR_MODEL_FEATURE_MATCHING sceneModel,
 						PTR_MODEL_FEATURE_MATCHING objectModel,
+						PTR_TRACKING_STATE state,
 						PTR_DRAW_FRAME roi,
 						bool isIRAUsed,
-						PTR_IMAGE_REDUCTION_ALGORITHM ira,
-						bool isROIUsed);
+						bool isROIUsed,
+						bool isRepeated,
+						std::vector<cv::KeyPoint>& sceneKeypoints,
+						cv::Mat& sceneDescriptors,
+						bool& isSceneDetected,
+						int& scoring);
 
 					/**
 					 * Ratio test implementation to improve results from matching to obtain only good results. <br>
 					 * Paper -> Neighborhoods comparison - <a href="http://www.cs.ubc.ca/~lowe/papers/ijcv04.pdf#page=20"> Paper </a>
+					 * Only the best good matches up to countMatches are kept, see SelectMatches().
 					 * @param matches Matches from feature matching.
 					 * @param good_matches Vector to store good matches.
 					 * @param ratio Ratio to determine which matches are good enough.
@@ -261,6 +666,28 @@ namespace Companion {
 						std::vector<cv::DMatch>& good_matches,
 						float ratio);
 
+					/**
+					 * Keep the countMatches best good matches ordered by distance. Selection is linear in the number of
+					 * good matches, only the kept matches are sorted.
+					 * @param good_matches Good matches to select from.
+					 */
+					void SelectMatches(std::vector<cv::DMatch>& good_matches) const;
+
+					/**
+					 * Geometric consistency check of good matches by histogram voting. Each match votes for the rotation
+					 * and the scale change between its object and scene keypoint, matches of a recognized object agree on
+					 * both. Rotation is not used if keypoints have no orientation.
+					 * @param good_matches Good matches ordered by distance.
+					 * @param keypoints_object Keypoints from object.
+					 * @param keypoints_scene Keypoints from scene.
+					 * @param consistent_matches Matches of the strongest rotation and scale, in the order of good_matches.
+					 * @return True if enough matches are consistent to search for a homography otherwise false.
+					 */
+					bool GeometricConsistency(const std::vector<cv::DMatch>& good_matches,
+						const std::vector<cv::KeyPoint>& keypoints_object,
+						const std::vector<cv::KeyPoint>& keypoints_scene,
+						std::vector<cv::DMatch>& consistent_matches) const;
+
 					/**
 					 * Filter to obtain only good feature point matches.
 					 * @param good_matches Good matches to store.
@@ -268,58 +695,158 @@ namespace Companion {
 					 * @param keypoints_scene Keypoints from scene.
 					 * @param feature_points_object Feature points from object.
 					 * @param feature_points_scene Feature points from scene.
+					 * @param feature_matches Good matches of the feature points, in the order of the feature points.
 					 */
 					void ObtainKeypointsFromGoodMatches(const std::vector<cv::DMatch>& good_matches,
 						const std::vector<cv::KeyPoint>& keypoints_object,
 						const std::vector<cv::KeyPoint>& keypoints_scene,
 						std::vector<cv::Point2f>& feature_points_object,
-						std::vector<cv::Point2f>& feature_points_scene);
+						std::vector<cv::Point2f>& feature_points_scene,
+						std::vector<cv::DMatch>& feature_matches);
+
+					/**
+					 * Calculate the scoring of a found homography.
+					 * @param feature_matches Matches of the feature points.
+					 * @param feature_points_object Feature points from object.
+					 * @param feature_points_scene Feature points from scene.
+					 * @param inliers Inlier mask of the homography, all points are inliers if empty.
+					 * @param homography Homography from object to scene.
+					 * @return Scoring between 0 and 100.
+					 */
+					int Scoring(const std::vector<cv::DMatch>& feature_matches,
+						const std::vector<cv::Point2f>& feature_points_object,
+						const std::vector<cv::Point2f>& feature_points_scene,
+						const std::vector<uchar>& inliers,
+						const cv::Mat& homography) const;
+
+					/**
+					 * Search instances of an object by matching scene keypoints against the object keypoints and by finding
+					 * one homography after another. IRA is not used.
+					 * @param sceneModel Scene model to verify for matching.
+					 * @param objectModel Object model to search in scene.
+					 * @param roi A region of interest where to search for the object (not used if nullptr).
+					 * @return Recognition result models of up to MaxInstances() found instances.
+					 */
+					std::vector<PTR_RESULT_RECOGNITION> SearchInstances(PTR_MODEL_FEATURE_MATCHING sceneModel,
+						PTR_MODEL_FEATURE_MATCHING objectModel,
+						PTR_DRAW_FRAME roi);
+
+					/**
+					 * Match each scene descriptor against the object descriptors and keep the matches which pass the ratio
+					 * test, so that all instances of the object obtain matches.
+					 * @param descriptorsObject Descriptors from object.
+					 * @param descriptorsScene Descriptors from scene.
+					 * @param good_matches Good matches with object keypoints as query and scene keypoints as train index,
+					 * ordered by distance.
+					 */
+					void MatchInstances(cv::Mat descriptorsObject,
+						cv::Mat descriptorsScene,
+						std::vector<cv::DMatch>& good_matches);
+
+					/**
+					 * Find the homography of one object instance and remove its inliers and all matches inside the instance
+					 * from the good matches.
+					 * @param objectImage Object image to recognize in scene.
+					 * @param good_matches Remaining good matches ordered by distance.
+					 * @param keypoints_object Keypoints from object.
+					 * @param keypoints_scene Keypoints from scene.
+					 * @param sModel Scene feature matching model.
+					 * @param isROIUsed Flag if ROI was used.
+					 * @param roi Region of interest.
+					 * @param drawable Drawable of the instance or nullptr if the found area is not a valid object shape or
+					 * its scoring is below the minimum scoring.
+					 * @param scoring Scoring of the instance.
+					 * @return True if an instance was found and its matches are removed, false if no more instances exist.
+					 */
+					bool ObtainInstance(cv::Mat& objectImage,
+						std::vector<cv::DMatch>& good_matches,
+						std::vector<cv::KeyPoint>& keypoints_object,
+						std::vector<cv::KeyPoint>& keypoints_scene,
+						PTR_MODEL_FEATURE_MATCHING sModel,
+						bool isROIUsed,
+						PTR_DRAW_FRAME roi,
+						PTR_DRAW& drawable,
+						int& scoring);
+
+					/**
+					 * Get offset of the searched area in the scene image.
+					 * @param state Tracking state of the object, only used if IRA was used.
+					 * @param isIRAUsed Flag if IRA was used.
+					 * @param isROIUsed Flag if ROI was used.
+					 * @param roi Region of interest.
+					 * @return Top left position of the IRA area or ROI, otherwise the origin.
+					 */
+					cv::Point2f SearchOffset(PTR_TRACKING_STATE state,
+						bool isIRAUsed,
+						bool isROIUsed,
+						PTR_DRAW_FRAME roi) const;
+
+					/**
+					 * Start the track of a recognized object with the homography inliers of its recognition.
+					 * @param feature_points_object Matched points in the object image.
+					 * @param feature_points_scene Matched points in the searched area of the scene image.
+					 * @param inliers Homography inlier mask of the matched points.
+					 * @param homography Homography from the object image to the searched area.
+					 * @param offset Offset of the searched area in the scene image.
+					 * @param sModel Feature matching model of the scene.
+					 * @param state Tracking state of the object.
+					 * @param scoring Scoring of the recognition.
+					 */
+					void StartTrack(const std::vector<cv::Point2f>& feature_points_object,
+						const std::vector<cv::Point2f>& feature_points_scene,
+						const std::vector<uchar>& inliers,
+						const cv::Mat& homography,
+						cv::Point2f offset,
+						PTR_MODEL_FEATURE_MATCHING sModel,
+						PTR_TRACKING_STATE state,
+						int scoring);
 
 					/**
 					 * Calculate area position from recognized object in scene.
 					 * @param homography Homography to find objects position.
-					 * @param sceneImage Scene image to recognize object image.
 					 * @param objectImage Object image to recognize in scene.
 					 * @param sModel Feature matching model of the scene.
-					 * @param cModel Feature matching model of the object.
+					 * @param state Tracking state of the object (not used if nullptr).
 					 * @param isIRAUsed Flag if IRA was used.
 					 * @param isROIUsed Flag if ROI was used.
 					 * @param roi Region of interest.
+					 * @param updateIRA Flag if the recognized position is stored to IRA if IRA is used.
 					 * @return A Drawable which contains the recognized object's position in the scene image.
 					 */
 					PTR_DRAW CalculateArea(cv::Mat& homography,
-						cv::Mat& sceneImage,
 						cv::Mat& objectImage,
 						PTR_MODEL_FEATURE_MATCHING sModel,
-						PTR_MODEL_FEATURE_MATCHING cModel,
+						PTR_TRACKING_STATE state,
 						bool isIRAUsed,
 						bool isROIUsed,
-						PTR_DRAW_FRAME roi);
+						PTR_DRAW_FRAME roi,
+						bool updateIRA);
 
 					/**
 					 * Obtain a result from given feature matching if an object was recognized in the image.
-					 * @param sceneImage Scene image.
 					 * @param objectImage Object image to recognize in scene.
 					 * @param good_matches Vector which contains good matches from object and scene.
 					 * @param keypoints_object Keypoints from object.
 					 * @param keypoints_scene Keypoints from scene.
 					 * @param sModel Scene feature matching model.
-					 * @param cModel Object feature matching model.
+					 * @param state Tracking state of the object (not used if nullptr).
 					 * @param isIRAUsed Flag if IRA was used.
 					 * @param isROIUsed Flag if ROI was used.
 					 * @param roi Region of interest.
-					 * @return <code>Nullptr</code> if object was not recognized, otherwise a Drawable which represents the recognized object.
+					 * @param scoring Scoring of the recognized object.
+					 * @return <code>Nullptr</code> if object was not recognized or its scoring is below the minimum scoring,
+					 * otherwise a Drawable which represents the recognized object.
 					 */
-					PTR_DRAW ObtainMatchingResult(cv::Mat& sceneImage,
-						cv::Mat& objectImage,
+					PTR_DRAW ObtainMatchingResult(cv::Mat& objectImage,
 						std::vector<cv::DMatch>& good_matches,
 						std::vector<cv::KeyPoint>& keypoints_object,
 						std::vector<cv::KeyPoint>& keypoints_scene,
 						PTR_MODEL_FEATURE_MATCHING sModel,
-						PTR_MODEL_FEATURE_MATCHING cModel,
+						PTR_TRACKING_STATE state,
 						bool isIRAUsed,
 						bool isROIUsed,
-						PTR_DRAW_FRAME roi);
+						PTR_DRAW_FRAME roi,
+						int& scoring);
 				};
 			}
 		}
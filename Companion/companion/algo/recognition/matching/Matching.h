@@ -19,10 +19,12 @@
 #ifndef COMPANION_MATCHING_H
 #define COMPANION_MATCHING_H
 
+#include <vector>
 #include <companion/algo/recognition/Recognition.h>
 #include <companion/draw/Frame.h>
 #include <companion/model/result/RecognitionResult.h>
 #include <companion/model/processing/FeatureMatchingModel.h>
+#include <companion/algo/recognition/matching/util/TrackingState.h>
 
 namespace Companion {
 	namespace Algorithm {
@@ -49,6 +51,31 @@ namespace Companion {
 						PTR_MODEL_FEATURE_MATCHING objectModel,
 						PTR_DRAW_FRAME roi) = 0;
 
+					/**
+					 * Matching algorithm implementation to search all instances of the given object model in a scene model.
+					 * By default only one instance is searched by ExecuteAlgorithm() and the tracking state is not used.
+					 * @param sceneModel Scene model to verify for matching.
+					 * @param objectModel Object model to search in scene.
+					 * @param roi A region of interest for object search (not used if nullptr).
+					 * @param state Tracking state of the object model in the stream of the scene (not used if nullptr).
+					 * @return Recognition result models of all recognized instances, empty if no object is recognized.
+					 */
+					virtual std::vector<PTR_RESULT_RECOGNITION> FindInstances(PTR_MODEL_FEATURE_MATCHING sceneModel,
+						PTR_MODEL_FEATURE_MATCHING objectModel,
+						PTR_DRAW_FRAME roi,
+						PTR_TRACKING_STATE /*state*/)
+					{
+						std::vector<PTR_RESULT_RECOGNITION> results;
+						PTR_RESULT_RECOGNITION result = ExecuteAlgorithm(sceneModel, objectModel, roi);
+
+						if (result != nullptr)
+						{
+							results.push_back(result);
+						}
+
+						return results;
+					}
+
 					/**
 					 * Indicator if this algorithm uses cuda.
 					 * @return True if cuda will be used otherwise false.
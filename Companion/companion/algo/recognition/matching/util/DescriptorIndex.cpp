@@ -0,0 +1,168 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DescriptorIndex.h"
+
+Companion::Algorithm::Recognition::Matching::DescriptorIndex::DescriptorIndex(cv::Ptr<cv::DescriptorMatcher> matcher,
+	int matcherType,
+	const std::vector<PTR_MODEL_FEATURE_MATCHING>& models)
+{
+	cv::Mat descriptors;
+	cv::Mat modelDescriptors;
+
+	this->matcherType = matcherType;
+	this->matcher = matcher->clone(true);
+
+	for (const PTR_MODEL_FEATURE_MATCHING& model : models)
+	{
+		modelDescriptors = model->Descriptors();
+		if (modelDescriptors.empty())
+		{
+			continue;
+		}
+
+		// If matching type is flan based, descriptors must be in CV_32F format
+		if (this->matcherType == cv::DescriptorMatcher::FLANNBASED)
+		{
+			modelDescriptors.convertTo(modelDescriptors, CV_32F);
+		}
+
+		this->modelRows.push_back(descriptors.rows);
+
+		// Tag each descriptor row with its model
+		for (int row = 0; row < modelDescriptors.rows; row++)
+		{
+			this->rowModels.push_back(static_cast<int>(this->models.size()));
+			this->rowDescriptors.push_back(row);
+		}
+
+		descriptors.push_back(modelDescriptors);
+		this->models.push_back(model);
+	}
+
+	this->modelRows.push_back(descriptors.rows);
+
+	if (!descriptors.empty())
+	{
+		// Single train image so that train indices are rows of all descriptors
+		this->matcher->add(std::vector<cv::Mat>(1, descriptors));
+		this->matcher->train();
+	}
+
+	if (this->matcherType == cv::DescriptorMatcher::BRUTEFORCE_HAMMING)
+	{
+		this->descriptors = descriptors;
+	}
+}
+
+void Companion::Algorithm::Recognition::Matching::DescriptorIndex::Match(const cv::Mat& sceneDescriptors,
+	float ratio,
+	std::vector<std::vector<cv::DMatch>>& modelMatches) const
+{
+	std::vector<std::vector<cv::DMatch>> matches;
+	std::vector<cv::DMatch> goodMatches;
+	std::vector<bool> votedModels;
+	cv::Mat descriptors = sceneDescriptors;
+	float secondDistance;
+	int model;
+	int row;
+
+	modelMatches = std::vector<std::vector<cv::DMatch>>(this->models.size());
+
+	if (IsEmpty() || descriptors.empty())
+	{
+		return;
+	}
+
+	if (this->matcherType == cv::DescriptorMatcher::FLANNBASED)
+	{
+		descriptors.convertTo(descriptors, CV_32F);
+	}
+
+	if (this->matcherType == cv::DescriptorMatcher::BRUTEFORCE_HAMMING && HammingMatcher::IsSupported(descriptors, this->descriptors))
+	{
+		// Rows of a model are contiguous, each model is matched with the ratio test inside the kernel
+		for (size_t m = 0; m < this->models.size(); m++)
+		{
+			HammingMatcher::Match(descriptors, this->descriptors.rowRange(this->modelRows[m], this->modelRows[m + 1]), ratio, goodMatches);
+			for (const cv::DMatch& match : goodMatches)
+			{
+				modelMatches[m].push_back(cv::DMatch(match.trainIdx, match.queryIdx, match.distance));
+			}
+		}
+		return;
+	}
+
+	// Single search of all scene descriptors over all models
+	this->matcher->knnMatch(descriptors, matches, NEIGHBORS);
+
+	for (size_t i = 0; i < matches.size(); i++)
+	{
+		votedModels.assign(this->models.size(), false);
+
+		for (size_t n = 0; n < matches[i].size(); n++)
+		{
+			row = matches[i][n].trainIdx;
+			model = this->rowModels[row];
+			if (votedModels[model])
+			{
+				continue;
+			}
+			votedModels[model] = true;
+
+			// Second neighbor of the same model, neighbors of other models are skipped
+			secondDistance = -1.0f;
+			for (size_t s = n + 1; s < matches[i].size(); s++)
+			{
+				if (this->rowModels[matches[i][s].trainIdx] == model)
+				{
+					secondDistance = matches[i][s].distance;
+					break;
+				}
+			}
+
+			if (secondDistance < 0.0f)
+			{
+				if (matches[i].size() < static_cast<size_t>(NEIGHBORS))
+				{
+					// All descriptors were searched, model has no second neighbor
+					continue;
+				}
+				// Second neighbor of the model is not closer than the last searched neighbor
+				secondDistance = matches[i].back().distance;
+			}
+
+			// Ratio test for good matches - http://www.cs.ubc.ca/~lowe/papers/ijcv04.pdf#page=20
+			if (matches[i][n].distance < ratio * secondDistance)
+			{
+				// Vote for model, object keypoint is query and scene keypoint is train like single model matches
+				modelMatches[model].push_back(cv::DMatch(this->rowDescriptors[row], matches[i][n].queryIdx, matches[i][n].distance));
+			}
+		}
+	}
+}
+
+const std::vector<PTR_MODEL_FEATURE_MATCHING>& Companion::Algorithm::Recognition::Matching::DescriptorIndex::Models() const
+{
+	return this->models;
+}
+
+bool Companion::Algorithm::Recognition::Matching::DescriptorIndex::IsEmpty() const
+{
+	return this->rowModels.empty();
+}
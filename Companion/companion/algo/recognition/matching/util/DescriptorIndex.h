@@ -0,0 +1,134 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_DESCRIPTORINDEX_H
+#define COMPANION_DESCRIPTORINDEX_H
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <companion/algo/recognition/matching/util/HammingMatcher.h>
+#include <companion/model/processing/FeatureMatchingModel.h>
+#include <companion/util/Definitions.h>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion {
+	namespace Algorithm {
+		namespace Recognition {
+			namespace Matching {
+				/**
+				 * Descriptor index over the descriptors of many object models. Each descriptor row is tagged with its
+				 * model, so a scene is matched once against all models instead of once per model.
+				 * @author Andreas Sekulski, Dimitri Kotlovsky
+				 */
+				class COMP_EXPORTS DescriptorIndex
+				{
+
+				public:
+
+					/**
+					 * Create a descriptor index over the given models. Models must have calculated descriptors of the
+					 * same type, models without descriptors are not indexed.
+					 * @param matcher Matcher whose type is used to search the index, it is cloned without its train data.
+					 * @param matcherType FeatureMatcher type which is used like FlannBased or Bruteforce.
+					 * @param models Object models to index.
+					 */
+					DescriptorIndex(cv::Ptr<cv::DescriptorMatcher> matcher,
+						int matcherType,
+						const std::vector<PTR_MODEL_FEATURE_MATCHING>& models);
+
+					/**
+					 * Destructor.
+					 */
+					virtual ~DescriptorIndex() = default;
+
+					/**
+					 * Match scene descriptors against all indexed models and keep the matches which pass the ratio test.
+					 * The ratio test compares neighbors of the same model like single model matching, so similar models
+					 * do not reject each others matches.
+					 * Matches are grouped by model, their query index is the object keypoint and their train index the
+					 * scene keypoint like matches from a single model.
+					 * @param sceneDescriptors Descriptors of the scene.
+					 * @param ratio Ratio test value to obtain only good matches.
+					 * @param modelMatches Matches of each indexed model, in the order of Models().
+					 */
+					void Match(const cv::Mat& sceneDescriptors,
+						float ratio,
+						std::vector<std::vector<cv::DMatch>>& modelMatches) const;
+
+					/**
+					 * Get indexed models.
+					 * @return Models which are part of this index.
+					 */
+					const std::vector<PTR_MODEL_FEATURE_MATCHING>& Models() const;
+
+					/**
+					 * Indicator if no descriptors are indexed.
+					 * @return True if the index is empty otherwise false.
+					 */
+					bool IsEmpty() const;
+
+				private:
+
+					/**
+					 * Nearest neighbors to search for the ratio test, more than two so that the second neighbor of a
+					 * model is found even if neighbors of other models lie in between.
+					 */
+					static constexpr int NEIGHBORS = 8;
+
+					/**
+					 * Matcher which holds the descriptors of all models.
+					 */
+					cv::Ptr<cv::DescriptorMatcher> matcher;
+
+					/**
+					 * FeatureMatcher type which is used like FlannBased or Bruteforce.
+					 */
+					int matcherType;
+
+					/**
+					 * Descriptors of all models, used for binary descriptors which are matched by the hamming matcher.
+					 */
+					cv::Mat descriptors;
+
+					/**
+					 * Indexed models.
+					 */
+					std::vector<PTR_MODEL_FEATURE_MATCHING> models;
+
+					/**
+					 * Model position in models of each indexed descriptor.
+					 */
+					std::vector<int> rowModels;
+
+					/**
+					 * Descriptor position inside its model of each indexed descriptor.
+					 */
+					std::vector<int> rowDescriptors;
+
+					/**
+					 * First descriptor row of each indexed model, the last entry is the number of indexed descriptors.
+					 */
+					std::vector<int> modelRows;
+				};
+			}
+		}
+	}
+}
+
+#endif //COMPANION_DESCRIPTORINDEX_H
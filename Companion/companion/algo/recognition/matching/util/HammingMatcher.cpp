@@ -0,0 +1,335 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HammingMatcher.h"
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <companion/util/Util.h>
+
+// SIMD kernels are compiled with function target attributes and selected at runtime
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define Companion_HAMMING_AVX2 1
+#include <immintrin.h>
+#if (defined(__clang__) && __clang_major__ >= 8) || (!defined(__clang__) && __GNUC__ >= 8)
+#define Companion_HAMMING_AVX512 1
+#endif
+#endif
+
+namespace
+{
+	/**
+	 * Tile kernel which compares query descriptors with the train descriptors [trainStart, trainEnd) and updates
+	 * the two nearest neighbors of each query descriptor.
+	 */
+	typedef void (*TileFunction)(const cv::Mat& query,
+		int queryStart,
+		int queryEnd,
+		const cv::Mat& train,
+		int trainStart,
+		int trainEnd,
+		int* best,
+		int* second,
+		int* bestIndex);
+
+	inline void UpdateBest(int distance, int trainIndex, int& best, int& second, int& bestIndex)
+	{
+		// Strict comparison keeps the first train descriptor on equal distances like the brute force matcher
+		if (distance < best)
+		{
+			second = best;
+			best = distance;
+			bestIndex = trainIndex;
+		}
+		else if (distance < second)
+		{
+			second = distance;
+		}
+	}
+
+	inline int DistanceScalar(const uchar* a, const uchar* b, int bytes)
+	{
+		uint64_t wordA;
+		uint64_t wordB;
+		int distance = 0;
+		int i = 0;
+
+		for (; i + 8 <= bytes; i += 8)
+		{
+			std::memcpy(&wordA, a + i, 8);
+			std::memcpy(&wordB, b + i, 8);
+			distance += Companion::Util::PopCount(wordA ^ wordB);
+		}
+
+		if (i < bytes)
+		{
+			// Zero padded tail, for example AKAZE descriptors with 61 bytes
+			wordA = 0;
+			wordB = 0;
+			std::memcpy(&wordA, a + i, bytes - i);
+			std::memcpy(&wordB, b + i, bytes - i);
+			distance += Companion::Util::PopCount(wordA ^ wordB);
+		}
+
+		return distance;
+	}
+
+	void MatchTileScalar(const cv::Mat& query, int queryStart, int queryEnd,
+		const cv::Mat& train, int trainStart, int trainEnd,
+		int* best, int* second, int* bestIndex)
+	{
+		const uchar* queryRow;
+
+		for (int q = queryStart; q < queryEnd; q++)
+		{
+			queryRow = query.ptr<uchar>(q);
+			for (int t = trainStart; t < trainEnd; t++)
+			{
+				UpdateBest(DistanceScalar(queryRow, train.ptr<uchar>(t), query.cols), t, best[q], second[q], bestIndex[q]);
+			}
+		}
+	}
+
+#if Companion_HAMMING_AVX2
+	__attribute__((target("popcnt")))
+	inline int DistanceTail(const uchar* a, const uchar* b, int i, int bytes)
+	{
+		uint64_t wordA;
+		uint64_t wordB;
+		int distance = 0;
+
+		for (; i + 8 <= bytes; i += 8)
+		{
+			std::memcpy(&wordA, a + i, 8);
+			std::memcpy(&wordB, b + i, 8);
+			distance += __builtin_popcountll(wordA ^ wordB);
+		}
+
+		if (i < bytes)
+		{
+			wordA = 0;
+			wordB = 0;
+			std::memcpy(&wordA, a + i, bytes - i);
+			std::memcpy(&wordB, b + i, bytes - i);
+			distance += __builtin_popcountll(wordA ^ wordB);
+		}
+
+		return distance;
+	}
+
+	__attribute__((target("avx2,popcnt")))
+	inline int DistanceAVX2(const uchar* a, const uchar* b, int bytes)
+	{
+		// Population count of each nibble by table lookup, bytes are summed up by sum of absolute differences
+		const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+		const __m256i lowMask = _mm256_set1_epi8(0x0f);
+		__m256i sum = _mm256_setzero_si256();
+		__m256i x;
+		__m256i count;
+		uint64_t lanes[4];
+		int i = 0;
+
+		for (; i + 32 <= bytes; i += 32)
+		{
+			x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+			count = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, _mm256_and_si256(x, lowMask)),
+				_mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), lowMask)));
+			sum = _mm256_add_epi64(sum, _mm256_sad_epu8(count, _mm256_setzero_si256()));
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+		return static_cast<int>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + DistanceTail(a, b, i, bytes);
+	}
+
+	__attribute__((target("avx2,popcnt")))
+	void MatchTileAVX2(const cv::Mat& query, int queryStart, int queryEnd,
+		const cv::Mat& train, int trainStart, int trainEnd,
+		int* best, int* second, int* bestIndex)
+	{
+		const uchar* queryRow;
+
+		for (int q = queryStart; q < queryEnd; q++)
+		{
+			queryRow = query.ptr<uchar>(q);
+			for (int t = trainStart; t < trainEnd; t++)
+			{
+				UpdateBest(DistanceAVX2(queryRow, train.ptr<uchar>(t), query.cols), t, best[q], second[q], bestIndex[q]);
+			}
+		}
+	}
+#endif
+
+#if Companion_HAMMING_AVX512
+	__attribute__((target("avx512f,avx512vl,avx512vpopcntdq,popcnt")))
+	inline int DistanceAVX512(const uchar* a, const uchar* b, int bytes)
+	{
+		__m512i sum = _mm512_setzero_si512();
+		__m256i sumHalf = _mm256_setzero_si256();
+		uint64_t lanes[8];
+		int i = 0;
+
+		for (; i + 64 <= bytes; i += 64)
+		{
+			sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(
+				_mm512_loadu_si512(reinterpret_cast<const void*>(a + i)),
+				_mm512_loadu_si512(reinterpret_cast<const void*>(b + i)))));
+		}
+
+		if (i + 32 <= bytes)
+		{
+			// 32 byte descriptors like ORB or the remainder of longer descriptors
+			sumHalf = _mm256_popcnt_epi64(_mm256_xor_si256(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))));
+			i += 32;
+		}
+
+		sum = _mm512_add_epi64(sum, _mm512_castsi256_si512(sumHalf));
+		_mm512_storeu_si512(reinterpret_cast<void*>(lanes), sum);
+		return static_cast<int>(lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7])
+			+ DistanceTail(a, b, i, bytes);
+	}
+
+	__attribute__((target("avx512f,avx512vl,avx512vpopcntdq,popcnt")))
+	void MatchTileAVX512(const cv::Mat& query, int queryStart, int queryEnd,
+		const cv::Mat& train, int trainStart, int trainEnd,
+		int* best, int* second, int* bestIndex)
+	{
+		const uchar* queryRow;
+
+		for (int q = queryStart; q < queryEnd; q++)
+		{
+			queryRow = query.ptr<uchar>(q);
+			for (int t = trainStart; t < trainEnd; t++)
+			{
+				UpdateBest(DistanceAVX512(queryRow, train.ptr<uchar>(t), query.cols), t, best[q], second[q], bestIndex[q]);
+			}
+		}
+	}
+#endif
+
+	Companion::Algorithm::Recognition::Matching::HammingMatcher::Kernel DetectKernel()
+	{
+#if Companion_HAMMING_AVX2
+		__builtin_cpu_init();
+#if Companion_HAMMING_AVX512
+		if (__builtin_cpu_supports("avx512vpopcntdq") && __builtin_cpu_supports("avx512vl"))
+		{
+			return Companion::Algorithm::Recognition::Matching::HammingMatcher::Kernel::AVX512;
+		}
+#endif
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+		{
+			return Companion::Algorithm::Recognition::Matching::HammingMatcher::Kernel::AVX2;
+		}
+#endif
+		return Companion::Algorithm::Recognition::Matching::HammingMatcher::Kernel::SCALAR;
+	}
+
+	TileFunction SelectTile(Companion::Algorithm::Recognition::Matching::HammingMatcher::Kernel kernel)
+	{
+		switch (kernel)
+		{
+#if Companion_HAMMING_AVX512
+		case Companion::Algorithm::Recognition::Matching::HammingMatcher::Kernel::AVX512:
+			return MatchTileAVX512;
+#endif
+#if Companion_HAMMING_AVX2
+		case Companion::Algorithm::Recognition::Matching::HammingMatcher::Kernel::AVX2:
+			return MatchTileAVX2;
+#endif
+		default:
+			return MatchTileScalar;
+		}
+	}
+}
+
+bool Companion::Algorithm::Recognition::Matching::HammingMatcher::IsSupported(const cv::Mat& queryDescriptors, const cv::Mat& trainDescriptors)
+{
+	return queryDescriptors.type() == CV_8UC1
+		&& trainDescriptors.type() == CV_8UC1
+		&& queryDescriptors.cols == trainDescriptors.cols;
+}
+
+void Companion::Algorithm::Recognition::Matching::HammingMatcher::Match(const cv::Mat& queryDescriptors,
+	const cv::Mat& trainDescriptors,
+	float ratio,
+	std::vector<cv::DMatch>& goodMatches,
+	int maxMatches,
+	float distanceBound)
+{
+	// Kernel is selected once, static initialization is thread safe
+	static const TileFunction tile = SelectTile(UsedKernel());
+	std::vector<int> best;
+	std::vector<int> second;
+	std::vector<int> bestIndex;
+	int queryEnd;
+	int trainEnd;
+	int boundMatches = 0;
+
+	goodMatches.clear();
+
+	// Ratio test needs two neighbors
+	if (queryDescriptors.empty() || trainDescriptors.rows < 2 || !IsSupported(queryDescriptors, trainDescriptors))
+	{
+		return;
+	}
+
+	best.assign(queryDescriptors.rows, INT_MAX);
+	second.assign(queryDescriptors.rows, INT_MAX);
+	bestIndex.assign(queryDescriptors.rows, -1);
+
+	// Query tile is compared against all train tiles while the train tile stays in the cache
+	for (int queryStart = 0; queryStart < queryDescriptors.rows; queryStart += QUERY_TILE)
+	{
+		queryEnd = queryStart + QUERY_TILE < queryDescriptors.rows ? queryStart + QUERY_TILE : queryDescriptors.rows;
+		for (int trainStart = 0; trainStart < trainDescriptors.rows; trainStart += TRAIN_TILE)
+		{
+			trainEnd = trainStart + TRAIN_TILE < trainDescriptors.rows ? trainStart + TRAIN_TILE : trainDescriptors.rows;
+			tile(queryDescriptors, queryStart, queryEnd, trainDescriptors, trainStart, trainEnd, best.data(), second.data(), bestIndex.data());
+		}
+
+		for (int q = queryStart; q < queryEnd; q++)
+		{
+			// Ratio test for good matches - http://www.cs.ubc.ca/~lowe/papers/ijcv04.pdf#page=20
+			if (static_cast<float>(best[q]) < ratio * static_cast<float>(second[q]))
+			{
+				goodMatches.push_back(cv::DMatch(q, bestIndex[q], static_cast<float>(best[q])));
+				if (static_cast<float>(best[q]) <= distanceBound)
+				{
+					boundMatches++;
+				}
+			}
+		}
+
+		if (maxMatches > 0 && distanceBound > 0.0f && boundMatches >= maxMatches)
+		{
+			// Enough matches are good enough, remaining query tiles are skipped
+			break;
+		}
+	}
+}
+
+Companion::Algorithm::Recognition::Matching::HammingMatcher::Kernel Companion::Algorithm::Recognition::Matching::HammingMatcher::UsedKernel()
+{
+	static const Kernel kernel = DetectKernel();
+	return kernel;
+}
@@ -0,0 +1,102 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_HAMMINGMATCHER_H
+#define COMPANION_HAMMINGMATCHER_H
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion {
+	namespace Algorithm {
+		namespace Recognition {
+			namespace Matching {
+				/**
+				 * Brute force matcher for binary descriptors like ORB, BRISK or AKAZE. Searches the two nearest neighbors
+				 * by Hamming distance and applies the ratio test directly, so only good matches are returned. Descriptors
+				 * are compared in tiles which fit into the CPU caches. The distance kernel is selected at runtime:
+				 * AVX-512 VPOPCNTDQ, AVX2 or a portable scalar implementation.
+				 * @author Andreas Sekulski, Dimitri Kotlovsky
+				 */
+				class COMP_EXPORTS HammingMatcher
+				{
+
+				public:
+
+					/**
+					 * Instruction sets of the distance kernels.
+					 */
+					enum class Kernel
+					{
+						SCALAR, ///< Portable 64 bit population count.
+						AVX2, ///< AVX2 population count with a nibble lookup table.
+						AVX512 ///< AVX-512 VPOPCNTDQ population count.
+					};
+
+					/**
+					 * Indicator if descriptors can be matched by this matcher.
+					 * @param queryDescriptors Query descriptors.
+					 * @param trainDescriptors Train descriptors.
+					 * @return True if both descriptors are binary (CV_8UC1) with equal length otherwise false.
+					 */
+					static bool IsSupported(const cv::Mat& queryDescriptors, const cv::Mat& trainDescriptors);
+
+					/**
+					 * Find the nearest train descriptor of each query descriptor and keep it if it passes the ratio test
+					 * against the second nearest train descriptor.
+					 * @param queryDescriptors Binary query descriptors (CV_8UC1), one descriptor per row.
+					 * @param trainDescriptors Binary train descriptors (CV_8UC1) with the same length.
+					 * @param ratio Ratio to determine which matches are good enough.
+					 * @param goodMatches Matches which passed the ratio test, ordered by query index.
+					 * @param maxMatches Number of matches with a distance below or equal to distanceBound after which the
+					 * remaining query descriptors are not matched anymore. Not used if maxMatches or distanceBound is <= 0.
+					 * @param distanceBound Hamming distance bound for the early exit.
+					 */
+					static void Match(const cv::Mat& queryDescriptors,
+						const cv::Mat& trainDescriptors,
+						float ratio,
+						std::vector<cv::DMatch>& goodMatches,
+						int maxMatches = 0,
+						float distanceBound = 0.0f);
+
+					/**
+					 * Get the distance kernel which is used on this CPU.
+					 * @return Kernel which is selected at runtime.
+					 */
+					static Kernel UsedKernel();
+
+				private:
+
+					/**
+					 * Number of query descriptors of a tile.
+					 */
+					static constexpr int QUERY_TILE = 64;
+
+					/**
+					 * Number of train descriptors of a tile, 256 descriptors of 64 bytes fit into the L1 cache.
+					 */
+					static constexpr int TRAIN_TILE = 256;
+				};
+			}
+		}
+	}
+}
+
+#endif //COMPANION_HAMMINGMATCHER_H
@@ -69,3 +69,35 @@ bool Companion::Algorithm::Recognition::Matching::IRA::IsObjectRecognized()
 {
 	return (this->lop.width > NO_OBJECT_RECOGNIZED) && (this->lop.height > NO_OBJECT_RECOGNIZED);
 }
+
+cv::Rect Companion::Algorithm::Recognition::Matching::IRA::SearchArea(const std::vector<cv::Point2f>& corners, const cv::Size& imageSize)
+{
+	float minX = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float minY = std::numeric_limits<float>::max();
+	float maxY = std::numeric_limits<float>::lowest();
+	float width;
+	float height;
+
+	if (corners.empty())
+	{
+		return cv::Rect();
+	}
+
+	for (const cv::Point2f& point : corners)
+	{
+		minX = std::min(minX, point.x);
+		maxX = std::max(maxX, point.x);
+		minY = std::min(minY, point.y);
+		maxY = std::max(maxY, point.y);
+	}
+
+	width = maxX - minX;
+	height = maxY - minY;
+
+	cv::Point2f start = cv::Point2f(minX - width / 2.0f, minY - height / 2.0f);
+	cv::Point2f end = cv::Point2f(maxX + width / 2.0f, maxY + height / 2.0f);
+
+	return cv::Rect(cv::Point(static_cast<int>(start.x), static_cast<int>(start.y)), cv::Point(static_cast<int>(end.x), static_cast<int>(end.y)))
+		& cv::Rect(0, 0, imageSize.width, imageSize.height);
+}
@@ -19,6 +19,9 @@
 #ifndef COMPANION_IRA_H
 #define COMPANION_IRA_H
 
+#include <algorithm>
+#include <limits>
+#include <vector>
 #include <opencv2/core/core.hpp>
 #include <companion/util/exportapi/ExportAPIDefinitions.h>
 
@@ -95,6 +98,15 @@ namespace Companion {
 					 */
 					bool IsObjectRecognized();
 
+					/**
+					 * Calculate the area to search for a recognized object. The bounding box of the object is enlarged by
+					 * half of its size on each side, so that the object is found again if it moves, and clipped to the image.
+					 * @param corners Corners of the recognized object.
+					 * @param imageSize Size of the image.
+					 * @return Search area inside the image, empty if the object is outside of the image.
+					 */
+					static cv::Rect SearchArea(const std::vector<cv::Point2f>& corners, const cv::Size& imageSize);
+
 				private:
 
 					/**
@@ -0,0 +1,104 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ObjectTrack.h"
+
+Companion::Algorithm::Recognition::Matching::ObjectTrack::ObjectTrack()
+{
+	this->startPoints = 0;
+	this->scoring = 0;
+	this->frames = 0;
+}
+
+void Companion::Algorithm::Recognition::Matching::ObjectTrack::Start(const std::vector<cv::Point2f>& objectPoints,
+	const std::vector<cv::Point2f>& scenePoints,
+	const cv::Mat& homography,
+	const cv::Mat& sceneImage,
+	int scoring)
+{
+	this->objectPoints = objectPoints;
+	this->scenePoints = scenePoints;
+	this->homography = homography.clone();
+	this->sceneImage = sceneImage;
+	this->startPoints = static_cast<int>(objectPoints.size());
+	this->scoring = scoring;
+	this->frames = 0;
+}
+
+void Companion::Algorithm::Recognition::Matching::ObjectTrack::Update(const std::vector<cv::Point2f>& objectPoints,
+	const std::vector<cv::Point2f>& scenePoints,
+	const cv::Mat& homography,
+	const cv::Mat& sceneImage)
+{
+	this->objectPoints = objectPoints;
+	this->scenePoints = scenePoints;
+	this->homography = homography;
+	this->sceneImage = sceneImage;
+	this->frames++;
+}
+
+void Companion::Algorithm::Recognition::Matching::ObjectTrack::Clear()
+{
+	this->objectPoints.clear();
+	this->scenePoints.clear();
+	this->homography.release();
+	this->sceneImage.release();
+	this->startPoints = 0;
+	this->scoring = 0;
+	this->frames = 0;
+}
+
+bool Companion::Algorithm::Recognition::Matching::ObjectTrack::IsTracking() const
+{
+	return this->startPoints > 0 && !this->homography.empty();
+}
+
+const std::vector<cv::Point2f>& Companion::Algorithm::Recognition::Matching::ObjectTrack::ObjectPoints() const
+{
+	return this->objectPoints;
+}
+
+const std::vector<cv::Point2f>& Companion::Algorithm::Recognition::Matching::ObjectTrack::ScenePoints() const
+{
+	return this->scenePoints;
+}
+
+const cv::Mat& Companion::Algorithm::Recognition::Matching::ObjectTrack::Homography() const
+{
+	return this->homography;
+}
+
+const cv::Mat& Companion::Algorithm::Recognition::Matching::ObjectTrack::SceneImage() const
+{
+	return this->sceneImage;
+}
+
+int Companion::Algorithm::Recognition::Matching::ObjectTrack::StartPoints() const
+{
+	return this->startPoints;
+}
+
+int Companion::Algorithm::Recognition::Matching::ObjectTrack::Scoring() const
+{
+	return this->scoring;
+}
+
+int Companion::Algorithm::Recognition::Matching::ObjectTrack::Frames() const
+{
+	return this->frames;
+}
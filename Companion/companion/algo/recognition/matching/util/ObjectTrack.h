@@ -0,0 +1,172 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_OBJECTTRACK_H
+#define COMPANION_OBJECTTRACK_H
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion {
+	namespace Algorithm {
+		namespace Recognition {
+			namespace Matching {
+				/**
+				 * Track of a recognized object between frames. It stores the inlier points of the last homography, so
+				 * that the object can be followed with optical flow instead of matching features in each frame.
+				 * @author Andreas Sekulski, Dimitri Kotlovsky
+				 */
+				class COMP_EXPORTS ObjectTrack
+				{
+
+				public:
+
+					/**
+					 * Default constructor to create an empty track.
+					 */
+					ObjectTrack();
+
+					/**
+					 * Destructor.
+					 */
+					virtual ~ObjectTrack() = default;
+
+					/**
+					 * Start the track from a recognition by feature matching.
+					 * @param objectPoints Inlier points in the object image.
+					 * @param scenePoints Inlier points in the scene image which belong to the object points.
+					 * @param homography Homography from the object image to the scene image.
+					 * @param sceneImage Scene image of the recognition.
+					 * @param scoring Scoring of the recognition.
+					 */
+					void Start(const std::vector<cv::Point2f>& objectPoints,
+						const std::vector<cv::Point2f>& scenePoints,
+						const cv::Mat& homography,
+						const cv::Mat& sceneImage,
+						int scoring);
+
+					/**
+					 * Update the track with the points followed into a new frame.
+					 * @param objectPoints Object points which are still tracked.
+					 * @param scenePoints Scene points of the tracked object points in the new frame.
+					 * @param homography Homography from the object image to the new frame.
+					 * @param sceneImage Grayscale image of the new frame.
+					 */
+					void Update(const std::vector<cv::Point2f>& objectPoints,
+						const std::vector<cv::Point2f>& scenePoints,
+						const cv::Mat& homography,
+						const cv::Mat& sceneImage);
+
+					/**
+					 * Clear the track, the object is searched by feature matching again.
+					 */
+					void Clear();
+
+					/**
+					 * Check if the object is tracked.
+					 * @return <code>True</code> if the track is started, otherwise <code>false</code>.
+					 */
+					bool IsTracking() const;
+
+					/**
+					 * Get inlier points in the object image which are tracked.
+					 * @return Tracked object points.
+					 */
+					const std::vector<cv::Point2f>& ObjectPoints() const;
+
+					/**
+					 * Get positions of the tracked points in the last frame.
+					 * @return Tracked scene points.
+					 */
+					const std::vector<cv::Point2f>& ScenePoints() const;
+
+					/**
+					 * Get homography from the object image to the last frame.
+					 * @return Homography of the last frame.
+					 */
+					const cv::Mat& Homography() const;
+
+					/**
+					 * Get image of the last frame.
+					 * @return Scene image of the last frame, grayscale if the track was updated.
+					 */
+					const cv::Mat& SceneImage() const;
+
+					/**
+					 * Get number of points when the track was started.
+					 * @return Number of inlier points of the recognition.
+					 */
+					int StartPoints() const;
+
+					/**
+					 * Get scoring of the recognition which started the track.
+					 * @return Scoring of the recognition.
+					 */
+					int Scoring() const;
+
+					/**
+					 * Get number of frames which are tracked since the recognition by feature matching.
+					 * @return Number of tracked frames.
+					 */
+					int Frames() const;
+
+				private:
+
+					/**
+					 * Tracked points in the object image.
+					 */
+					std::vector<cv::Point2f> objectPoints;
+
+					/**
+					 * Tracked points in the last frame.
+					 */
+					std::vector<cv::Point2f> scenePoints;
+
+					/**
+					 * Homography from the object image to the last frame.
+					 */
+					cv::Mat homography;
+
+					/**
+					 * Image of the last frame.
+					 */
+					cv::Mat sceneImage;
+
+					/**
+					 * Number of points when the track was started.
+					 */
+					int startPoints;
+
+					/**
+					 * Scoring of the recognition which started the track.
+					 */
+					int scoring;
+
+					/**
+					 * Number of tracked frames since the recognition.
+					 */
+					int frames;
+
+				};
+			}
+		}
+	}
+}
+
+#endif //COMPANION_OBJECTTRACK_H
@@ -0,0 +1,44 @@
+/*
+ * This program is an object recognition framework written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TrackingContext.h"
+
+PTR_TRACKING_STATE Companion::Algorithm::Recognition::Matching::TrackingContext::State(const PTR_MODEL_FEATURE_MATCHING& model)
+{
+	std::lock_guard<std::mutex> lk(this->statesMx);
+	PTR_TRACKING_STATE& state = this->states[model.get()];
+
+	if (state == nullptr)
+	{
+		state = std::make_shared<TRACKING_STATE>();
+	}
+
+	return state;
+}
+
+void Companion::Algorithm::Recognition::Matching::TrackingContext::Remove(const PTR_MODEL_FEATURE_MATCHING& model)
+{
+	std::lock_guard<std::mutex> lk(this->statesMx);
+	this->states.erase(model.get());
+}
+
+void Companion::Algorithm::Recognition::Matching::TrackingContext::Clear()
+{
+	std::lock_guard<std::mutex> lk(this->statesMx);
+	this->states.clear();
+}
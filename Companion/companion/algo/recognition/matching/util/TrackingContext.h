@@ -0,0 +1,90 @@
+/*
+ * This program is an object recognition framework written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_TRACKINGCONTEXT_H
+#define COMPANION_TRACKINGCONTEXT_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <companion/algo/recognition/matching/util/TrackingState.h>
+#include <companion/model/processing/FeatureMatchingModel.h>
+#include <companion/util/Definitions.h>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion {
+	namespace Algorithm {
+		namespace Recognition {
+			namespace Matching {
+				/**
+				 * Recognition states of all object models in one stream. Each stream owns its context, so object models
+				 * can be shared read only between several streams without sharing their IRA positions and tracks.
+				 * @author Andreas Sekulski, Dimitri Kotlovsky
+				 */
+				class COMP_EXPORTS TrackingContext
+				{
+
+				public:
+
+					/**
+					 * Default constructor to create an empty context.
+					 */
+					TrackingContext() = default;
+
+					/**
+					 * Destructor.
+					 */
+					virtual ~TrackingContext() = default;
+
+					/**
+					 * Get state of the given object model, the state is created if the model has no state yet.
+					 * @param model Object model to obtain its state.
+					 * @return State of the object model in this context.
+					 */
+					PTR_TRACKING_STATE State(const PTR_MODEL_FEATURE_MATCHING& model);
+
+					/**
+					 * Remove state of the given object model if it exists.
+					 * @param model Object model whose state is removed.
+					 */
+					void Remove(const PTR_MODEL_FEATURE_MATCHING& model);
+
+					/**
+					 * Remove states of all object models.
+					 */
+					void Clear();
+
+				private:
+
+					/**
+					 * States of the object models.
+					 */
+					std::map<const MODEL_FEATURE_MATCHING*, PTR_TRACKING_STATE> states;
+
+					/**
+					 * Mutex to lock the states.
+					 */
+					std::mutex statesMx;
+
+				};
+			}
+		}
+	}
+}
+
+#endif //COMPANION_TRACKINGCONTEXT_H
@@ -0,0 +1,46 @@
+/*
+ * This program is an object recognition framework written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TrackingState.h"
+
+Companion::Algorithm::Recognition::Matching::TrackingState::TrackingState()
+{
+	this->ira = std::make_shared<IMAGE_REDUCTION_ALGORITHM>();
+	this->track = std::make_shared<OBJECT_TRACK>();
+}
+
+PTR_IMAGE_REDUCTION_ALGORITHM Companion::Algorithm::Recognition::Matching::TrackingState::Ira() const
+{
+	return this->ira;
+}
+
+PTR_OBJECT_TRACK Companion::Algorithm::Recognition::Matching::TrackingState::Track() const
+{
+	return this->track;
+}
+
+std::mutex& Companion::Algorithm::Recognition::Matching::TrackingState::Mutex()
+{
+	return this->mx;
+}
+
+void Companion::Algorithm::Recognition::Matching::TrackingState::Clear()
+{
+	this->ira->Clear();
+	this->track->Clear();
+}
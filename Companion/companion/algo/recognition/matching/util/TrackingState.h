@@ -0,0 +1,100 @@
+/*
+ * This program is an object recognition framework written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_TRACKINGSTATE_H
+#define COMPANION_TRACKINGSTATE_H
+
+#include <memory>
+#include <mutex>
+#include <companion/algo/recognition/matching/util/IRA.h>
+#include <companion/algo/recognition/matching/util/ObjectTrack.h>
+#include <companion/util/Definitions.h>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion {
+	namespace Algorithm {
+		namespace Recognition {
+			namespace Matching {
+				/**
+				 * Recognition state of one object model in one stream. It stores the last recognized position for IRA
+				 * and the track of the object, so that object models do not change while they are searched.
+				 * @author Andreas Sekulski, Dimitri Kotlovsky
+				 */
+				class COMP_EXPORTS TrackingState
+				{
+
+				public:
+
+					/**
+					 * Default constructor to create an empty state.
+					 */
+					TrackingState();
+
+					/**
+					 * Destructor.
+					 */
+					virtual ~TrackingState() = default;
+
+					/**
+					 * Get IRA class to store last recognized object's location.
+					 * @return IRA class to obtain informations about last recognized object' location.
+					 */
+					PTR_IMAGE_REDUCTION_ALGORITHM Ira() const;
+
+					/**
+					 * Get track to follow the recognized object between frames.
+					 * @return Track of the recognized object.
+					 */
+					PTR_OBJECT_TRACK Track() const;
+
+					/**
+					 * Get mutex to lock this state while its object is searched in a frame, frames of one stream can be
+					 * processed by several threads.
+					 * @return Mutex of this state.
+					 */
+					std::mutex& Mutex();
+
+					/**
+					 * Clear last recognized object's position and track.
+					 */
+					void Clear();
+
+				private:
+
+					/**
+					 * Image reduction algorithm to store last recognized object's location.
+					 */
+					PTR_IMAGE_REDUCTION_ALGORITHM ira;
+
+					/**
+					 * Track to follow the recognized object between frames.
+					 */
+					PTR_OBJECT_TRACK track;
+
+					/**
+					 * Mutex to lock this state while its object is searched.
+					 */
+					std::mutex mx;
+
+				};
+			}
+		}
+	}
+}
+
+#endif //COMPANION_TRACKINGSTATE_H
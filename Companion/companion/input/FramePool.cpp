@@ -0,0 +1,92 @@
+/*
+ * This program is an object recognition framework written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FramePool.h"
+
+Companion::Input::FramePool::FramePool(int maxFrames)
+{
+
+	if (maxFrames <= 0)
+	{
+		maxFrames = 8;
+	}
+
+	this->maxFrames = maxFrames;
+}
+
+cv::Mat Companion::Input::FramePool::Obtain(cv::Size size, int type)
+{
+	std::lock_guard<std::mutex> lk(this->mx);
+	cv::Mat* freeFrame = nullptr;
+
+	for (cv::Mat& frame : this->frames)
+	{
+		if (IsFree(frame))
+		{
+			if (frame.size() == size && frame.type() == type)
+			{
+				// Free buffer with matching dimensions, no allocation needed
+				return frame;
+			}
+
+			freeFrame = &frame;
+		}
+	}
+
+	if (this->frames.size() < static_cast<size_t>(this->maxFrames))
+	{
+		// Pool is not full, new buffer will be recycled
+		this->frames.push_back(cv::Mat(size, type));
+		return this->frames.back();
+	}
+
+	if (freeFrame != nullptr)
+	{
+		// Reallocate a free buffer for the new dimensions, for example if the resolution of the source has changed
+		freeFrame->create(size, type);
+		return *freeFrame;
+	}
+
+	// All buffers are in use
+	return cv::Mat(size, type);
+}
+
+cv::Mat Companion::Input::FramePool::Copy(const cv::Mat& image)
+{
+	cv::Mat frame = Obtain(image.size(), image.type());
+	image.copyTo(frame);
+	return frame;
+}
+
+int Companion::Input::FramePool::Size()
+{
+	std::lock_guard<std::mutex> lk(this->mx);
+	return static_cast<int>(this->frames.size());
+}
+
+void Companion::Input::FramePool::Clear()
+{
+	std::lock_guard<std::mutex> lk(this->mx);
+	this->frames.clear();
+}
+
+bool Companion::Input::FramePool::IsFree(cv::Mat& frame)
+{
+	// Buffer is free if only this pool holds a reference to it
+	return (frame.u != nullptr) && (CV_XADD(&frame.u->refcount, 0) == 1);
+}
@@ -0,0 +1,106 @@
+/*
+ * This program is an object recognition framework written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_FRAMEPOOL_H
+#define COMPANION_FRAMEPOOL_H
+
+#include <vector>
+#include <mutex>
+#include <opencv2/core/core.hpp>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion {
+	namespace Input
+	{
+		/**
+		 * Pool of preallocated image buffers which are recycled to avoid large heap allocations for every frame.
+		 * A buffer is handed out as cv::Mat and returns to the pool as soon as all cv::Mat references to it are released.
+		 * @author Andreas Sekulski, Dimitri Kotlovsky
+		 */
+		class COMP_EXPORTS FramePool
+		{
+
+		public:
+
+			/**
+			 * Constructor to create an empty frame pool.
+			 * @param maxFrames Maximum number of buffers in this pool. If maxFrames <= 0 the pool holds 8 buffers.
+			 */
+			FramePool(int maxFrames = 8);
+
+			/**
+			 * Destructor.
+			 */
+			virtual ~FramePool() = default;
+
+			/**
+			 * Obtain an image buffer with the given size and type. A free buffer of the pool is used if one exists,
+			 * otherwise a new buffer is allocated and stored in the pool if the pool is not full.
+			 * The content of the returned buffer is undefined.
+			 * @param size Size of the image.
+			 * @param type OpenCV type of the image, for example CV_8UC3.
+			 * @return Image buffer with the given size and type.
+			 */
+			cv::Mat Obtain(cv::Size size, int type);
+
+			/**
+			 * Obtain a copy of the given image which is stored in a buffer of this pool.
+			 * @param image Image to copy.
+			 * @return Copy of the given image.
+			 */
+			cv::Mat Copy(const cv::Mat& image);
+
+			/**
+			 * Get number of buffers which are stored in this pool.
+			 * @return Number of buffers.
+			 */
+			int Size();
+
+			/**
+			 * Remove all buffers from this pool. Buffers which are still in use are released by their last user.
+			 */
+			void Clear();
+
+		private:
+
+			/**
+			 * Mutex to lock the pool.
+			 */
+			std::mutex mx;
+
+			/**
+			 * Buffers of this pool.
+			 */
+			std::vector<cv::Mat> frames;
+
+			/**
+			 * Maximum number of buffers in this pool.
+			 */
+			int maxFrames;
+
+			/**
+			 * Check if the given buffer is not used outside of this pool.
+			 * @param frame Buffer of this pool.
+			 * @return <code>True</code> if the buffer is free, <code>false</code> otherwise.
+			 */
+			bool IsFree(cv::Mat& frame);
+		};
+	}
+}
+
+#endif //COMPANION_FRAMEPOOL_H
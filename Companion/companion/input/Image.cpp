@@ -23,11 +23,50 @@ Companion::Input::Image::Image(int maxImages)
 	this->exitStream = false;
 	this->exitAfterProcessing = false;
 	this->maxImages = maxImages;
+	this->imageType = 0;
 }
 
 bool Companion::Input::Image::AddImage(std::string imgPath)
 {
-	return AddImage(cv::imread(imgPath));
+	PTR_FRAME_POOL framePool = this->framePool;
+	std::vector<uchar> data;
+	cv::Mat img;
+
+	if (framePool == nullptr)
+	{
+		return AddImage(cv::imread(imgPath));
+	}
+
+	std::ifstream file(imgPath, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	{
+		std::lock_guard<std::mutex> lk(this->mx);
+		if (this->imageSize.area() > 0)
+		{
+			// Decode image into a recycled buffer which has the dimensions of the last image
+			img = framePool->Obtain(this->imageSize, this->imageType);
+		}
+	}
+
+	if (cv::imdecode(data, cv::IMREAD_COLOR, &img).empty())
+	{
+		// Decoding failed and the buffer keeps stale content, release it so the pool can recycle it
+		img.release();
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(this->mx);
+		this->imageSize = img.size();
+		this->imageType = img.type();
+	}
+
+	return AddImage(img);
 }
 
 bool Companion::Input::Image::AddImage(cv::Mat img)
@@ -47,6 +86,14 @@ bool Companion::Input::Image::AddImage(cv::Mat img)
 
 bool Companion::Input::Image::AddImage(int width, int height, int type, uchar* data)
 {
+	PTR_FRAME_POOL framePool = this->framePool;
+
+	if (framePool != nullptr)
+	{
+		// Copy data so that the caller can reuse its memory
+		return AddImage(framePool->Copy(cv::Mat(cv::Size(width, height), type, data)));
+	}
+
 	return AddImage(cv::Mat(cv::Size(width, height), type, data));
 }
 
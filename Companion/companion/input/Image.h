@@ -20,6 +20,9 @@
 #define COMPANION_IMAGE_H
 
 #include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
@@ -52,7 +55,7 @@ namespace Companion {
 			virtual ~Image() = default;
 
 			/**
-			 * Store image from given path to FIFO.
+			 * Store image from given path to FIFO. If a frame pool is set the image is decoded into a recycled buffer.
 			 * @param imgPath Image path to store image from.
 			 * @return <code>True</code> if the image was stored and <code>false</code> if image not exists.
 			 */
@@ -66,7 +69,8 @@ namespace Companion {
 			bool AddImage(cv::Mat img);
 
 			/**
-			 * Store a given image to FIFO.
+			 * Store a given image to FIFO. If a frame pool is set the data is copied into a recycled buffer and can be
+			 * reused by the caller, otherwise the data is not copied and must be valid until the image is processed.
 			 * @param width Width of the image to store.
 			 * @param height Height of the image to store.
 			 * @param type Type of the image to store.
@@ -128,6 +132,16 @@ namespace Companion {
 			 * Maximum amount of images that can be loaded at the same time.
 			 */
 			int maxImages;
+
+			/**
+			 * Size of the last decoded image to obtain a matching buffer from the frame pool.
+			 */
+			cv::Size imageSize;
+
+			/**
+			 * Type of the last decoded image to obtain a matching buffer from the frame pool.
+			 */
+			int imageType;
 		};
 	}
 }
@@ -19,6 +19,8 @@
 #ifndef COMPANION_STREAM_H
 #define COMPANION_STREAM_H
 
+#include <companion/input/FramePool.h>
+#include <companion/util/Definitions.h>
 #include <companion/util/exportapi/ExportAPIDefinitions.h>
 
 namespace Companion {
@@ -49,6 +51,26 @@ namespace Companion {
 			 * Stop this stream.
 			 */
 			virtual void Finish() = 0;
+
+			/**
+			 * Set a frame pool to obtain image buffers from. Streams which support a frame pool store obtained images
+			 * in recycled buffers of this pool instead of allocating new images.
+			 * @param framePool Frame pool to use or nullptr to allocate new images.
+			 */
+			virtual void FramePool(PTR_FRAME_POOL framePool);
+
+			/**
+			 * Get frame pool if set.
+			 * @return Frame pool of this stream or nullptr if no frame pool is set.
+			 */
+			PTR_FRAME_POOL FramePool() const;
+
+		protected:
+
+			/**
+			 * Frame pool to obtain image buffers from.
+			 */
+			PTR_FRAME_POOL framePool;
 		};
 	}
 }
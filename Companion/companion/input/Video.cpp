@@ -29,6 +29,7 @@ Companion::Input::Video::Video(int device)
 
 	this->capture = cap;
 	this->finished = false;
+	this->frameType = 0;
 }
 
 
@@ -43,6 +44,7 @@ Companion::Input::Video::Video(std::string url)
 
 	this->capture = cap;
 	this->finished = false;
+	this->frameType = 0;
 }
 
 cv::Mat Companion::Input::Video::ObtainImage()
@@ -55,14 +57,25 @@ cv::Mat Companion::Input::Video::ObtainImage()
 		return frame;
 	}
 
+	if (this->framePool != nullptr && this->frameSize.area() > 0)
+	{
+		// Decode frame into a recycled buffer which has the dimensions of the last frame
+		frame = this->framePool->Obtain(this->frameSize, this->frameType);
+	}
+
 	// Obtain image frame
-	this->capture >> frame;
+	this->capture.read(frame);
 
 	if (frame.empty())
 	{
 		// If frame empty video is finished
 		this->finished = true;
 	}
+	else
+	{
+		this->frameSize = frame.size();
+		this->frameType = frame.type();
+	}
 
 	return frame;
 }
@@ -57,7 +57,7 @@ namespace Companion {
 			virtual ~Video() = default;
 
 			/**
-			 * Obtain next image from open video stream.
+			 * Obtain next image from open video stream. If a frame pool is set the image is decoded into a recycled buffer.
 			 * @return An empty cv::Mat object if no image is obtained otherwise a cv::Mat entity from the obtained image.
 			 */
 			cv::Mat ObtainImage();
@@ -84,6 +84,16 @@ namespace Companion {
 			 * Indicator if video has finished.
 			 */
 			bool finished;
+
+			/**
+			 * Size of the last obtained frame to obtain a matching buffer from the frame pool.
+			 */
+			cv::Size frameSize;
+
+			/**
+			 * Type of the last obtained frame to obtain a matching buffer from the frame pool.
+			 */
+			int frameType;
 		};
 	}
 }
@@ -0,0 +1,346 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FeatureCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+Companion::Model::Processing::FeatureCache::FeatureCache(const std::string& path)
+{
+	this->path = path;
+	this->data = nullptr;
+	this->size = 0;
+	this->mapped = false;
+	Open();
+}
+
+Companion::Model::Processing::FeatureCache::~FeatureCache()
+{
+	Close();
+}
+
+bool Companion::Model::Processing::FeatureCache::Load(PTR_MODEL_FEATURE_MATCHING model, uint64_t parametersKey) const
+{
+	std::pair<uint64_t, uint64_t> key(ImageHash(model->Image()), parametersKey);
+	std::map<std::pair<uint64_t, uint64_t>, size_t>::const_iterator offset;
+	std::map<std::pair<uint64_t, uint64_t>, Entry>::const_iterator entry;
+	std::vector<cv::KeyPoint> keypoints;
+	EntryHeader header;
+	KeypointEntry keypoint;
+	const char* position;
+
+	offset = this->offsets.find(key);
+	if (offset != this->offsets.end())
+	{
+		position = this->data + offset->second;
+		std::memcpy(&header, position, sizeof(EntryHeader));
+		position += sizeof(EntryHeader);
+
+		keypoints.reserve(header.keypoints);
+		for (int32_t i = 0; i < header.keypoints; i++)
+		{
+			std::memcpy(&keypoint, position, sizeof(KeypointEntry));
+			position += sizeof(KeypointEntry);
+			keypoints.push_back(cv::KeyPoint(keypoint.x, keypoint.y, keypoint.size, keypoint.angle, keypoint.response, keypoint.octave, keypoint.classId));
+		}
+
+		model->Keypoints(keypoints);
+		// Copy descriptors because models outlive the mapped file
+		model->Descriptors(cv::Mat(header.rows, header.cols, header.type, const_cast<char*>(position)).clone());
+		return true;
+	}
+
+	std::lock_guard<std::mutex> lk(this->mx);
+	entry = this->entries.find(key);
+	if (entry != this->entries.end())
+	{
+		model->Keypoints(entry->second.keypoints);
+		model->Descriptors(entry->second.descriptors);
+		return true;
+	}
+
+	return false;
+}
+
+void Companion::Model::Processing::FeatureCache::Store(PTR_MODEL_FEATURE_MATCHING model, uint64_t parametersKey)
+{
+	std::pair<uint64_t, uint64_t> key(ImageHash(model->Image()), parametersKey);
+	Entry entry;
+
+	if (this->offsets.find(key) != this->offsets.end())
+	{
+		// Entry already exists in the cache file
+		return;
+	}
+
+	entry.id = model->ID();
+	entry.keypoints = model->Keypoints();
+	entry.descriptors = model->Descriptors().isContinuous() ? model->Descriptors() : model->Descriptors().clone();
+
+	std::lock_guard<std::mutex> lk(this->mx);
+	this->entries[key] = entry;
+}
+
+void Companion::Model::Processing::FeatureCache::Save()
+{
+	std::lock_guard<std::mutex> lk(this->mx);
+	std::string tempPath = this->path + ".tmp";
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	uint64_t magic = MAGIC;
+	uint32_t version = VERSION;
+	uint32_t count = static_cast<uint32_t>(this->offsets.size() + this->entries.size());
+	EntryHeader header;
+	KeypointEntry keypoint;
+
+	if (!file.is_open())
+	{
+		throw Error::Code::invalid_feature_cache;
+	}
+
+	file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+	file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+	// Loaded entries are copied as they are
+	for (const std::pair<const std::pair<uint64_t, uint64_t>, size_t>& offset : this->offsets)
+	{
+		std::memcpy(&header, this->data + offset.second, sizeof(EntryHeader));
+		file.write(this->data + offset.second, EntrySize(header));
+	}
+
+	for (const std::pair<const std::pair<uint64_t, uint64_t>, Entry>& entry : this->entries)
+	{
+		header.id = entry.second.id;
+		header.keypoints = static_cast<int32_t>(entry.second.keypoints.size());
+		header.imageHash = entry.first.first;
+		header.parametersKey = entry.first.second;
+		header.rows = entry.second.descriptors.rows;
+		header.cols = entry.second.descriptors.cols;
+		header.type = entry.second.descriptors.type();
+		header.reserved = 0;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(EntryHeader));
+
+		for (const cv::KeyPoint& kp : entry.second.keypoints)
+		{
+			keypoint = { kp.pt.x, kp.pt.y, kp.size, kp.angle, kp.response, kp.octave, kp.class_id };
+			file.write(reinterpret_cast<const char*>(&keypoint), sizeof(KeypointEntry));
+		}
+
+		file.write(reinterpret_cast<const char*>(entry.second.descriptors.data), entry.second.descriptors.total() * entry.second.descriptors.elemSize());
+	}
+
+	file.close();
+	if (file.fail())
+	{
+		throw Error::Code::invalid_feature_cache;
+	}
+
+#if defined(_WIN32)
+	// Windows does not replace existing files by rename, the old file is not opened because it was read into memory
+	std::remove(this->path.c_str());
+#endif
+	if (std::rename(tempPath.c_str(), this->path.c_str()) != 0)
+	{
+		throw Error::Code::invalid_feature_cache;
+	}
+}
+
+size_t Companion::Model::Processing::FeatureCache::Size() const
+{
+	std::lock_guard<std::mutex> lk(this->mx);
+	return this->offsets.size() + this->entries.size();
+}
+
+uint64_t Companion::Model::Processing::FeatureCache::ImageHash(const cv::Mat& image)
+{
+	uint64_t hash = FNV_OFFSET;
+	int dimensions[3] = { image.rows, image.cols, image.type() };
+	size_t rowLength = image.cols * image.elemSize();
+
+	Hash(hash, dimensions, sizeof(dimensions));
+	for (int row = 0; row < image.rows; row++)
+	{
+		Hash(hash, image.ptr(row), rowLength);
+	}
+
+	return hash;
+}
+
+uint64_t Companion::Model::Processing::FeatureCache::ParametersKey(cv::Ptr<cv::FeatureDetector> detector,
+	cv::Ptr<cv::DescriptorExtractor> extractor,
+	const std::string& parametersTag)
+{
+	uint64_t hash = FNV_OFFSET;
+	std::string parameters;
+	int formats[3] = { extractor->descriptorSize(), extractor->descriptorType(), extractor->defaultNorm() };
+
+	for (const cv::Ptr<cv::Feature2D>& algorithm : { detector, extractor })
+	{
+		// Algorithms which serialize their parameters change the key if a parameter changes
+		cv::FileStorage fs(".yml", cv::FileStorage::WRITE | cv::FileStorage::MEMORY);
+		algorithm->write(fs);
+		parameters = algorithm->getDefaultName() + fs.releaseAndGetString();
+		Hash(hash, parameters.data(), parameters.size());
+	}
+
+	Hash(hash, formats, sizeof(formats));
+	// Parameters which are not serialized by the algorithms
+	Hash(hash, parametersTag.data(), parametersTag.size());
+	return hash;
+}
+
+void Companion::Model::Processing::FeatureCache::Open()
+{
+	uint64_t magic;
+	uint32_t version;
+	uint32_t count;
+	size_t position;
+	size_t entrySize;
+	EntryHeader header;
+
+#if defined(_WIN32)
+	std::ifstream file(this->path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		return;
+	}
+
+	this->buffer.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(this->buffer.data(), this->buffer.size());
+	if (file.fail())
+	{
+		this->buffer.clear();
+		return;
+	}
+
+	this->data = this->buffer.data();
+	this->size = this->buffer.size();
+#else
+	struct stat fileStat;
+	void* mapping;
+	int fd = open(this->path.c_str(), O_RDONLY);
+
+	if (fd < 0)
+	{
+		return;
+	}
+
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(fd);
+		return;
+	}
+
+	mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+	{
+		return;
+	}
+
+	this->data = static_cast<const char*>(mapping);
+	this->size = static_cast<size_t>(fileStat.st_size);
+	this->mapped = true;
+#endif
+
+	position = sizeof(magic) + sizeof(version) + sizeof(count);
+	if (this->size < position)
+	{
+		Close();
+		return;
+	}
+
+	std::memcpy(&magic, this->data, sizeof(magic));
+	std::memcpy(&version, this->data + sizeof(magic), sizeof(version));
+	std::memcpy(&count, this->data + sizeof(magic) + sizeof(version), sizeof(count));
+	if (magic != MAGIC || version != VERSION)
+	{
+		// Unknown file, cache is rebuilt on save
+		Close();
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (this->size - position < sizeof(EntryHeader))
+		{
+			break;
+		}
+
+		std::memcpy(&header, this->data + position, sizeof(EntryHeader));
+		entrySize = EntrySize(header);
+		if (entrySize == 0 || this->size - position < entrySize)
+		{
+			// Truncated file, following entries are calculated again
+			break;
+		}
+
+		this->offsets[std::make_pair(header.imageHash, header.parametersKey)] = position;
+		position += entrySize;
+	}
+}
+
+void Companion::Model::Processing::FeatureCache::Close()
+{
+#if !defined(_WIN32)
+	if (this->mapped)
+	{
+		munmap(const_cast<char*>(this->data), this->size);
+	}
+#endif
+
+	this->buffer.clear();
+	this->offsets.clear();
+	this->data = nullptr;
+	this->size = 0;
+	this->mapped = false;
+}
+
+size_t Companion::Model::Processing::FeatureCache::EntrySize(const EntryHeader& header)
+{
+
+	if (header.keypoints < 0 || header.rows < 0 || header.cols < 0 || header.type < 0)
+	{
+		return 0;
+	}
+
+	return sizeof(EntryHeader)
+		+ static_cast<size_t>(header.keypoints) * sizeof(KeypointEntry)
+		+ static_cast<size_t>(header.rows) * header.cols * CV_ELEM_SIZE(header.type);
+}
+
+void Companion::Model::Processing::FeatureCache::Hash(uint64_t& hash, const void* data, size_t length)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+}
@@ -0,0 +1,257 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_FEATURECACHE_H
+#define COMPANION_FEATURECACHE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <opencv2/core/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <companion/model/processing/FeatureMatchingModel.h>
+#include <companion/util/CompanionError.h>
+#include <companion/util/Definitions.h>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion {
+	namespace Model {
+		namespace Processing
+		{
+			/**
+			 * Persistent cache of model keypoints and descriptors. Entries are identified by a hash of the model image and
+			 * a key of the detector and extractor parameters, so a changed image or feature configuration is calculated
+			 * again. The cache file is memory mapped on load (read into memory on Windows) and only written by Save().
+			 *
+			 * File layout (native byte order): a header with magic number, version and number of entries, followed by
+			 * the entries. Each entry consists of its id, image hash, parameters key, number of keypoints, descriptor
+			 * rows, columns and type, the keypoints (x, y, size, angle, response, octave, class id) and the raw
+			 * descriptor data.
+			 * @author Andreas Sekulski, Dimitri Kotlovsky
+			 */
+			class COMP_EXPORTS FeatureCache
+			{
+
+			public:
+
+				/**
+				 * Open a feature cache. Entries of an existing cache file are loaded, a missing file or a file of
+				 * another version results in an empty cache.
+				 * @param path Path of the cache file.
+				 */
+				explicit FeatureCache(const std::string& path);
+
+				/**
+				 * Not copyable because the cache owns the mapped file.
+				 */
+				FeatureCache(const FeatureCache&) = delete;
+
+				/**
+				 * Not copyable because the cache owns the mapped file.
+				 */
+				FeatureCache& operator=(const FeatureCache&) = delete;
+
+				/**
+				 * Unmaps the cache file.
+				 */
+				virtual ~FeatureCache();
+
+				/**
+				 * Load keypoints and descriptors of the given model from this cache.
+				 * @param model Model whose image is used to find the entry.
+				 * @param parametersKey Key of the detector and extractor parameters.
+				 * @return <code>True</code> if keypoints and descriptors were set, <code>false</code> if no entry exists.
+				 */
+				bool Load(PTR_MODEL_FEATURE_MATCHING model, uint64_t parametersKey) const;
+
+				/**
+				 * Store calculated keypoints and descriptors of the given model. Stored entries are written by Save().
+				 * @param model Model with calculated keypoints and descriptors.
+				 * @param parametersKey Key of the detector and extractor parameters.
+				 */
+				void Store(PTR_MODEL_FEATURE_MATCHING model, uint64_t parametersKey);
+
+				/**
+				 * Write all entries to the cache file. The file is replaced so that a running process which maps
+				 * the old file is not affected.
+				 * @throws Companion::Error::Code error code if the cache file could not be written.
+				 */
+				void Save();
+
+				/**
+				 * Get number of entries.
+				 * @return Number of loaded and stored entries.
+				 */
+				size_t Size() const;
+
+				/**
+				 * Calculate a FNV-1a hash of an image including its dimensions and type.
+				 * @param image Image to hash.
+				 * @return Hash of the image.
+				 */
+				static uint64_t ImageHash(const cv::Mat& image);
+
+				/**
+				 * Calculate a key from the names, descriptor formats and serialized parameters of a detector and an
+				 * extractor and from the given parameters tag.
+				 * IMPORTANT: Parameters are only part of the key if the algorithm serializes them by write(). ORB and
+				 * other OpenCV 3 algorithms do not, so changing for example nfeatures or scaleFactor keeps the key and
+				 * stale keypoints are loaded. For these algorithms the parameters or a version must be given as tag.
+				 * @param detector Feature detector.
+				 * @param extractor Descriptor extractor.
+				 * @param parametersTag Parameters or version of the detector and extractor chosen by the caller.
+				 * @return Key of the feature parameters.
+				 */
+				static uint64_t ParametersKey(cv::Ptr<cv::FeatureDetector> detector,
+					cv::Ptr<cv::DescriptorExtractor> extractor,
+					const std::string& parametersTag = "");
+
+			private:
+
+				/**
+				 * Identifies the cache file format.
+				 */
+				static constexpr uint64_t MAGIC = 0x4548434143504d43ULL; // "CMPCACHE"
+
+				/**
+				 * Version of the cache file format.
+				 */
+				static constexpr uint32_t VERSION = 1;
+
+				/**
+				 * Start value of the FNV-1a hash.
+				 */
+				static constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+
+				/**
+				 * Prime of the FNV-1a hash.
+				 */
+				static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+				/**
+				 * Fixed size part of an entry.
+				 */
+				struct EntryHeader
+				{
+					int32_t id; ///< ID of the model.
+					int32_t keypoints; ///< Number of keypoints.
+					uint64_t imageHash; ///< Hash of the model image.
+					uint64_t parametersKey; ///< Key of the detector and extractor parameters.
+					int32_t rows; ///< Descriptor rows.
+					int32_t cols; ///< Descriptor columns.
+					int32_t type; ///< Descriptor type.
+					int32_t reserved; ///< Padding, always 0.
+				};
+
+				/**
+				 * Serialized keypoint.
+				 */
+				struct KeypointEntry
+				{
+					float x; ///< X coordinate.
+					float y; ///< Y coordinate.
+					float size; ///< Diameter of the keypoint neighborhood.
+					float angle; ///< Orientation of the keypoint.
+					float response; ///< Detector response.
+					int32_t octave; ///< Pyramid octave.
+					int32_t classId; ///< Object class.
+				};
+
+				/**
+				 * Cache entry which is not written yet.
+				 */
+				struct Entry
+				{
+					int id; ///< ID of the model.
+					std::vector<cv::KeyPoint> keypoints; ///< Calculated keypoints.
+					cv::Mat descriptors; ///< Calculated descriptors.
+				};
+
+				/**
+				 * Path of the cache file.
+				 */
+				std::string path;
+
+				/**
+				 * Loaded file data.
+				 */
+				const char* data;
+
+				/**
+				 * Size of the loaded file data.
+				 */
+				size_t size;
+
+				/**
+				 * File data if memory mapping is not used.
+				 */
+				std::vector<char> buffer;
+
+				/**
+				 * Indicator if the file data is memory mapped.
+				 */
+				bool mapped;
+
+				/**
+				 * Offsets of the loaded entries by image hash and parameters key.
+				 */
+				std::map<std::pair<uint64_t, uint64_t>, size_t> offsets;
+
+				/**
+				 * Stored entries by image hash and parameters key.
+				 */
+				std::map<std::pair<uint64_t, uint64_t>, Entry> entries;
+
+				/**
+				 * Mutex to lock the stored entries.
+				 */
+				mutable std::mutex mx;
+
+				/**
+				 * Map or read the cache file and index its entries.
+				 */
+				void Open();
+
+				/**
+				 * Unmap or release the cache file.
+				 */
+				void Close();
+
+				/**
+				 * Get size of an entry.
+				 * @param header Header of the entry.
+				 * @return Size of the entry in bytes or 0 if the header is invalid.
+				 */
+				static size_t EntrySize(const EntryHeader& header);
+
+				/**
+				 * Add data to a FNV-1a hash.
+				 * @param hash Hash to update.
+				 * @param data Data to add.
+				 * @param length Length of the data in bytes.
+				 */
+				static void Hash(uint64_t& hash, const void* data, size_t length);
+			};
+		}
+	}
+}
+
+#endif //COMPANION_FEATURECACHE_H
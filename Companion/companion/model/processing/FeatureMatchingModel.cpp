@@ -20,7 +20,7 @@
 
 Companion::Model::Processing::FeatureMatchingModel::FeatureMatchingModel()
 {
-	this->ira = std::make_shared<IMAGE_REDUCTION_ALGORITHM>();
+	this->prepared = false;
 }
 
 Companion::Model::Processing::FeatureMatchingModel::~FeatureMatchingModel()
@@ -76,9 +76,23 @@ void Companion::Model::Processing::FeatureMatchingModel::Image(const cv::Mat& im
 	this->image = image;
 }
 
-PTR_IMAGE_REDUCTION_ALGORITHM Companion::Model::Processing::FeatureMatchingModel::Ira() const
+void Companion::Model::Processing::FeatureMatchingModel::Prepare(const std::function<void()>& calculate)
 {
-	return this->ira;
+
+	if (this->prepared)
+	{
+		// Keypoints and descriptors are only read from now on
+		return;
+	}
+
+	std::lock_guard<std::mutex> lk(this->prepareMx);
+
+	if (!this->KeypointsCalculated())
+	{
+		calculate();
+	}
+
+	this->prepared = this->KeypointsCalculated();
 }
 
 void Companion::Model::Processing::FeatureMatchingModel::ID(int id)
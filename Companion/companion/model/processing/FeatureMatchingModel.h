@@ -19,10 +19,13 @@
 #ifndef COMPANION_FEATUREMATCHINGMODEL_H
 #define COMPANION_FEATUREMATCHINGMODEL_H
 
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <opencv2/core/core.hpp>
 #include <opencv2/features2d.hpp>
-#include <companion/algo/recognition/matching/util/IRA.h>
 #include <companion/util/Definitions.h>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
 
 namespace Companion {
 	namespace Model {
@@ -99,10 +102,12 @@ namespace Companion {
 				void Image(const cv::Mat& image);
 
 				/**
-				 * Get IRA class to store last recognized object's location.
-				 * @return IRA class to obtain informations about last recognized object' location.
+				 * Calculate keypoints and descriptors with the given function if they are not calculated yet. Models can
+				 * be shared between several streams, so the function is called by one thread only and other threads
+				 * wait until the keypoints and descriptors are calculated.
+				 * @param calculate Function which calculates keypoints and descriptors of this model.
 				 */
-				PTR_IMAGE_REDUCTION_ALGORITHM Ira() const;
+				void Prepare(const std::function<void()>& calculate);
 
 				/**
 				 * Set the ID for this model.
@@ -139,9 +144,14 @@ namespace Companion {
 				cv::Mat image;
 
 				/**
-				 * Image reduction algorithm to store last recognized object's location.
+				 * Indicator if keypoints and descriptors are prepared, models are not changed afterwards.
 				 */
-				PTR_IMAGE_REDUCTION_ALGORITHM ira;
+				std::atomic<bool> prepared;
+
+				/**
+				 * Mutex to lock the preparation of keypoints and descriptors.
+				 */
+				std::mutex prepareMx;
 
 			};
 		}
@@ -0,0 +1,107 @@
+/*
+ * This program is an object recognition framework written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HashIndex.h"
+
+#include <companion/util/Util.h>
+
+Companion::Model::Processing::HashIndex::HashIndex(const cv::Mat& images, const std::vector<int>& ids, int hashSize)
+{
+	std::default_random_engine gen;
+	std::normal_distribution<float> dist(0, 1);
+	cv::Mat bits;
+
+	this->ids = ids;
+	this->hashSize = hashSize;
+	this->words = (hashSize + 63) / 64;
+	this->projection = cv::Mat_<float>(images.cols, hashSize);
+
+	for (int i = 0; i < this->projection.rows; i++)
+	{
+		for (int j = 0; j < this->projection.cols; j++)
+		{
+			this->projection.at<float>(i, j) = dist(gen);
+		}
+	}
+
+	if (!images.empty())
+	{
+		// Positive projections are hash bits
+		cv::compare(images * this->projection, 0.0, bits, cv::CMP_GT);
+		Pack(bits, this->hashes);
+	}
+}
+
+const cv::Mat_<float>& Companion::Model::Processing::HashIndex::Projection() const
+{
+	return this->projection;
+}
+
+int Companion::Model::Processing::HashIndex::Distance(const uint64_t* hash, int row) const
+{
+	const uint64_t* modelHash = this->hashes.data() + static_cast<size_t>(row) * this->words;
+	int distance = 0;
+
+	for (int i = 0; i < this->words; i++)
+	{
+		distance += Util::PopCount(hash[i] ^ modelHash[i]);
+	}
+
+	return distance;
+}
+
+int Companion::Model::Processing::HashIndex::Words() const
+{
+	return this->words;
+}
+
+void Companion::Model::Processing::HashIndex::Pack(const cv::Mat& bits, std::vector<uint64_t>& hashes)
+{
+	int words = (bits.cols + 63) / 64;
+	const uchar* rowBits;
+	uint64_t* rowHash;
+
+	hashes.assign(static_cast<size_t>(bits.rows) * words, 0);
+	for (int i = 0; i < bits.rows; i++)
+	{
+		rowBits = bits.ptr<uchar>(i);
+		rowHash = hashes.data() + static_cast<size_t>(i) * words;
+		for (int j = 0; j < bits.cols; j++)
+		{
+			if (rowBits[j])
+			{
+				rowHash[j / 64] |= uint64_t(1) << (j % 64);
+			}
+		}
+	}
+}
+
+const std::vector<int>& Companion::Model::Processing::HashIndex::Ids() const
+{
+	return this->ids;
+}
+
+int Companion::Model::Processing::HashIndex::HashSize() const
+{
+	return this->hashSize;
+}
+
+bool Companion::Model::Processing::HashIndex::IsEmpty() const
+{
+	return this->hashes.empty();
+}
@@ -0,0 +1,133 @@
+/*
+ * This program is an object recognition framework written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_HASHINDEX_H
+#define COMPANION_HASHINDEX_H
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <companion/util/Definitions.h>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion {
+	namespace Model {
+		namespace Processing
+		{
+			/**
+			 * Immutable hash index of image models. The index holds the random projection and the hash of each model
+			 * image, so queries are compared with the index without generating or copying the dataset. The index is
+			 * rebuilt by its image hash model if models are added and can be shared by several queries. Hashes are
+			 * packed into 64 bit words, so a hamming distance is calculated by XOR and population count per word.
+			 * @author Andreas Sekulski, Dimitri Kotlovsky
+			 */
+			class COMP_EXPORTS HashIndex {
+
+			public:
+
+				/**
+				 * Create a hash index from one dimensional model images.
+				 * @param images Model images as CV_32F rows with equal size.
+				 * @param ids Model ID of each image row.
+				 * @param hashSize Number of hash bits of each image.
+				 */
+				HashIndex(const cv::Mat& images, const std::vector<int>& ids, int hashSize);
+
+				/**
+				 * Destructor.
+				 */
+				virtual ~HashIndex() = default;
+
+				/**
+				 * Get random projection which hashes one dimensional images.
+				 * @return Projection matrix with one row per image pixel and one column per hash bit.
+				 */
+				const cv::Mat_<float>& Projection() const;
+
+				/**
+				 * Calculate the hamming distance between a packed query hash and the hash of a model.
+				 * @param hash Packed query hash with Words() words.
+				 * @param row Row of the model in this index.
+				 * @return Number of different hash bits.
+				 */
+				int Distance(const uint64_t* hash, int row) const;
+
+				/**
+				 * Get number of 64 bit words of each packed hash.
+				 * @return Number of words per hash.
+				 */
+				int Words() const;
+
+				/**
+				 * Pack hash bits into 64 bit words.
+				 * @param bits Hash bits with one hash per row (CV_8U), each bit is set if its column is not zero.
+				 * @param hashes Packed hashes, one hash after another with (bits.cols + 63) / 64 words each.
+				 */
+				static void Pack(const cv::Mat& bits, std::vector<uint64_t>& hashes);
+
+				/**
+				 * Get model ID of each hash row.
+				 * @return Model IDs in the order of the hash rows.
+				 */
+				const std::vector<int>& Ids() const;
+
+				/**
+				 * Get number of hash bits of each image.
+				 * @return Number of hash bits.
+				 */
+				int HashSize() const;
+
+				/**
+				 * Indicator if no model is indexed.
+				 * @return True if the index is empty otherwise false.
+				 */
+				bool IsEmpty() const;
+
+			private:
+
+				/**
+				 * Random projection to hash images.
+				 */
+				cv::Mat_<float> projection;
+
+				/**
+				 * Packed hashes of all model images, one hash after another.
+				 */
+				std::vector<uint64_t> hashes;
+
+				/**
+				 * Model ID of each hash row.
+				 */
+				std::vector<int> ids;
+
+				/**
+				 * Number of hash bits of each image.
+				 */
+				int hashSize;
+
+				/**
+				 * Number of 64 bit words of each packed hash.
+				 */
+				int words;
+			};
+		}
+	}
+}
+
+#endif //COMPANION_HASHINDEX_H
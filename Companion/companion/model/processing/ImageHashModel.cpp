@@ -20,71 +20,45 @@
 
 Companion::Model::Processing::ImageHashModel::ImageHashModel()
 {
-	this->newModelAdded = true;
+	this->hashSize = HASH_SIZE;
+	this->index = nullptr;
 }
 
 void Companion::Model::Processing::ImageHashModel::AddDescriptor(int id, cv::Mat& descriptor)
 {
+	std::lock_guard<std::mutex> lk(this->indexMx);
 	this->imageDataset.push_back(descriptor);
 	// Store this id for a scoring
-	this->scores.push_back({ id, 0.0f });
-	this->newModelAdded = true;
+	this->ids.push_back(id);
+	this->index = nullptr;
 }
 
-std::pair<cv::Mat_<float>, cv::Mat> Companion::Model::Processing::ImageHashModel::GenerateDataset()
+PTR_HASH_INDEX Companion::Model::Processing::ImageHashModel::Index()
 {
-	std::pair<cv::Mat_<float>, cv::Mat> dataset;
-	dataset.first = GenerateHashImages();
-	dataset.second = GenerateIndexDataset(dataset.first);
-	this->newModelAdded = false;
-	return dataset;
-}
+	std::lock_guard<std::mutex> lk(this->indexMx);
 
-cv::Mat_<float> Companion::Model::Processing::ImageHashModel::GenerateHashImages()
-{
-	if (this->newModelAdded)
+	if (this->index == nullptr)
 	{
-		cv::Mat_<float> hash(this->imageDataset.cols, 100.0f);
-		std::default_random_engine gen;
-		std::normal_distribution<float> dist(0, 1);
-
-		for (int i = 0; i < hash.rows; i++)
-		{
-			for (int j = 0; j < hash.cols; j++)
-			{
-				hash.at<float>(i, j) = dist(gen);
-			}
-		}
-
-		this->hash = hash;
+		this->index = std::make_shared<HASH_INDEX>(this->imageDataset, this->ids, this->hashSize);
 	}
 
-	return this->hash;
+	return this->index;
 }
 
-cv::Mat Companion::Model::Processing::ImageHashModel::GenerateIndexDataset(cv::Mat_<float> hash)
+int Companion::Model::Processing::ImageHashModel::HashSize() const
 {
-	if (this->newModelAdded)
-	{
-		cv::Mat images = this->imageDataset * hash;
-
-		for (size_t i = 0; i < images.rows; i++)
-		{
-			for (size_t j = 0; j < images.cols; j++)
-			{
-				images.at<float>(i, j) = images.at<float>(i, j) > 0 ? 1 : 0;
-			}
-		}
+	return this->hashSize;
+}
 
-		images.convertTo(images, CV_8U);
+void Companion::Model::Processing::ImageHashModel::HashSize(int hashSize)
+{
+	std::lock_guard<std::mutex> lk(this->indexMx);
 
-		this->indexDataset = images;
+	if (hashSize <= 0)
+	{
+		hashSize = 1;
 	}
 
-	return this->indexDataset;
-}
-
-const std::vector<std::pair<int, float>>& Companion::Model::Processing::ImageHashModel::Scores() const
-{
-	return this->scores;
+	this->hashSize = hashSize;
+	this->index = nullptr;
 }
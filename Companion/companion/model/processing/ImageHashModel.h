@@ -21,9 +21,10 @@
 
 #include <vector>
 #include <string>
-#include <random>
+#include <mutex>
 #include <opencv2/core.hpp>
 #include <opencv2/opencv.hpp>
+#include <companion/model/processing/HashIndex.h>
 #include <companion/util/Definitions.h>
 #include <companion/util/exportapi/ExportAPIDefinitions.h>
 
@@ -40,6 +41,11 @@ namespace Companion {
 
 			public:
 
+				/**
+				 * Default number of hash bits of each image.
+				 */
+				static constexpr int HASH_SIZE = 100;
+
 				/**
 				 * Constructor.
 				 */
@@ -51,30 +57,33 @@ namespace Companion {
 				virtual ~ImageHashModel() = default;
 
 				/**
-				 * Add descriptor from given image.
+				 * Add descriptor from given image. The hash index is rebuilt on its next use.
 				 * @param id ID of the model.
 				 * @param descriptor Descriptor to add.
 				 */
 				void AddDescriptor(int id, cv::Mat& descriptor);
 
 				/**
-				 * Generate dataset from current image hash model.
-				 * @return Generated dataset that contains as first element the hashed images and as second element the index dataset.
+				 * Get hash index of all added descriptors, it is built once after descriptors are added. The returned
+				 * index is not changed by following descriptors, so it can be used by several queries at once.
+				 * @return Hash index of all models.
 				 */
-				std::pair<cv::Mat_<float>, cv::Mat> GenerateDataset();
+				PTR_HASH_INDEX Index();
 
 				/**
-				 * Return the result scores.
-				 * @return Result scores.
+				 * Get number of hash bits of each image.
+				 * @return Number of hash bits.
 				 */
-				const std::vector<std::pair<int, float>>& Scores() const;
-
-			private:
+				int HashSize() const;
 
 				/**
-				 * Indicates whether a new model was added.
+				 * Set number of hash bits of each image, the hash index is rebuilt on its next use. More bits separate
+				 * similar models better but need more memory and time to compare.
+				 * @param hashSize Number of hash bits, at least one.
 				 */
-				bool newModelAdded;
+				void HashSize(int hashSize);
+
+			private:
 
 				/**
 				 * Raw image models to compare in an one dimensional array.
@@ -82,32 +91,24 @@ namespace Companion {
 				cv::Mat imageDataset;
 
 				/**
-				 * Hash values to store from all models.
-				 */
-				cv::Mat_<float> hash;
-
-				/**
-				 * Index dataset from all models.
+				 * Model ID of each image row.
 				 */
-				cv::Mat indexDataset;
+				std::vector<int> ids;
 
 				/**
-				 * Scores from all given models.
+				 * Number of hash bits of each image.
 				 */
-				std::vector<std::pair<int, float>> scores;
+				int hashSize;
 
 				/**
-				 * Generate hash values from all image descriptors.
-				 * @return 1D Image hash matrix.
+				 * Hash index of all models, nullptr if descriptors are added since it was built.
 				 */
-				cv::Mat_<float> GenerateHashImages();
+				PTR_HASH_INDEX index;
 
 				/**
-				 * Generate index dataset from given hash.
-				 * @param hash Image hash to generate index dataset.
-				 * @return Index dataset from image hash.
+				 * Mutex to lock the descriptors and the creation of the hash index.
 				 */
-				cv::Mat GenerateIndexDataset(cv::Mat_<float> hash);
+				std::mutex indexMx;
 			};
 		}
 	}
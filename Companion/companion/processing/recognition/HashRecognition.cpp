@@ -20,12 +20,14 @@
 
 Companion::Processing::Recognition::HashRecognition::HashRecognition(cv::Size modelSize,
 	PTR_SHAPE_DETECTION shapeDetection,
-	PTR_HASHING hashing)
+	PTR_HASHING hashing,
+	int hashSize)
 {
     this->modelSize = modelSize;
     this->shapeDetection = shapeDetection;
     this->hashing = hashing;
     this->model = std::make_shared<MODEL_IMAGE_HASHING>();
+    this->model->HashSize(hashSize);
 }
 
 bool Companion::Processing::Recognition::HashRecognition::AddModel(int id, cv::Mat image)
@@ -56,7 +58,8 @@ CALLBACK_RESULT Companion::Processing::Recognition::HashRecognition::Execute(cv:
 {
     cv::Mat query;
     CALLBACK_RESULT results;
-	PTR_RESULT_RECOGNITION result;
+    std::vector<cv::Mat> queries;
+    std::vector<std::vector<PTR_RESULT_RECOGNITION>> roiResults;
     std::map<int, PTR_RESULT_RECOGNITION> scorings;
 
     // Obtain all shapes from the image to recognize
@@ -66,8 +69,14 @@ CALLBACK_RESULT Companion::Processing::Recognition::HashRecognition::Execute(cv:
         query = Util::CutImage(frame, frames.at(i)->CutArea());
         Companion::Util::ResizeImage(query, this->modelSize);
         Companion::Util::ConvertColor(query, query, Companion::ColorFormat::GRAY);
-        result = this->hashing->ExecuteAlgorithm(this->model, query, frames.at(i));
-        if (result != nullptr)
+        queries.push_back(query);
+    }
+
+    // All ROIs of the frame are compared in one batch
+    roiResults = this->hashing->ExecuteAlgorithm(this->model, queries, frames);
+    for (const std::vector<PTR_RESULT_RECOGNITION>& rank : roiResults)
+    {
+        for (PTR_RESULT_RECOGNITION result : rank)
         {
             // Score only best results from ROIs
             if (scorings.find(result->Id()) == scorings.end()) {
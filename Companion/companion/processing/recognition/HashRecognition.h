@@ -43,10 +43,12 @@ namespace Companion {
 				 * @param modelSize Model size in pixels.
 				 * @param shapeDetection Shape detection algorithm to detect ROI's.
 				 * @param hashing Hashing algorithm implementation, for example LSH.
+				 * @param hashSize Number of hash bits of each model image.
 				 */
 				HashRecognition(cv::Size modelSize,
 					PTR_SHAPE_DETECTION shapeDetection,
-					PTR_HASHING hashing);
+					PTR_HASHING hashing,
+					int hashSize = MODEL_IMAGE_HASHING::HASH_SIZE);
 
 				/**
 				 * Default destructor.
@@ -25,6 +25,7 @@ Companion::Processing::Recognition::HybridRecognition::HybridRecognition(PTR_HAS
 	this->featureMatching = featureMatching;
 	this->featureMatching->UseIRA(false);
 	this->resize = resize;
+	this->taskPool = Thread::TaskPool::Default();
 }
 
 void Companion::Processing::Recognition::HybridRecognition::AddModel(cv::Mat image, int id)
@@ -48,53 +49,51 @@ void Companion::Processing::Recognition::HybridRecognition::ClearModels()
 	// ToDo delete method for hashRecognition...
 }
 
+PTR_TASK_POOL Companion::Processing::Recognition::HybridRecognition::TaskPool() const
+{
+	return this->taskPool;
+}
+
+void Companion::Processing::Recognition::HybridRecognition::TaskPool(PTR_TASK_POOL taskPool)
+{
+
+	if (taskPool == nullptr)
+	{
+		taskPool = Thread::TaskPool::Default();
+	}
+
+	this->taskPool = taskPool;
+}
+
 CALLBACK_RESULT Companion::Processing::Recognition::HybridRecognition::Execute(cv::Mat frame)
 {
 	CALLBACK_RESULT results;
-	std::vector<CALLBACK_RESULT> parallelizedResults;
-	cv::Mat roiFrame;
-	std::vector<Companion::Error::Code> errors;
-	PTR_RESULT hashResult;
+	std::vector<CALLBACK_RESULT> hashMatchResults;
 	std::vector<PTR_RESULT> hashResults;
-	int threads;
 
-	threads = omp_get_max_threads();
-	parallelizedResults = std::vector<CALLBACK_RESULT>(threads);
 	hashResults = this->hashRecognition->Execute(frame);
 
 	if (!hashResults.empty())
 	{
-		errors.clear();
-#pragma omp parallel for
-		for (int i = 0; i < hashResults.size(); i++)
+		// Each hash result stores its verified results in its own list so that results keep the hash result order
+		hashMatchResults = std::vector<CALLBACK_RESULT>(hashResults.size());
+
+		// Throws Companion::Error::CompanionException with the errors of all hash results
+		this->taskPool->ParallelFor(static_cast<int>(hashResults.size()), [&](int i)
 		{
-			try
-			{
-				hashResult = hashResults.at(i);
-				if (hashResult != nullptr)
-				{
-					Processing(hashResult, frame, parallelizedResults[omp_get_thread_num()]);
-				}
-			}
-			catch (Companion::Error::Code errorCode)
+			PTR_RESULT hashResult = hashResults.at(i);
+			if (hashResult != nullptr)
 			{
-#pragma omp critical
-				errors.push_back(errorCode);
+				Processing(hashResult, frame, hashMatchResults[i]);
 			}
-		}
-
-		if (!errors.empty())
-		{
-			throw Companion::Error::CompanionException(errors);
-		}
+		});
 	}
 
-#pragma omp critical
-	for (int i = 0; i < threads; i++)
+	for (size_t i = 0; i < hashMatchResults.size(); i++)
 	{
-		for (int j = 0; j < parallelizedResults[i].size(); j++)
+		for (size_t j = 0; j < hashMatchResults[i].size(); j++)
 		{
-			results.push_back(std::shared_ptr<RESULT>(parallelizedResults[i].at(j)));
+			results.push_back(std::shared_ptr<RESULT>(hashMatchResults[i].at(j)));
 		}
 	}
 
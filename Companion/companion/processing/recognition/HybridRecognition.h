@@ -25,7 +25,7 @@
 #include <companion/algo/recognition/matching/FeatureMatching.h>
 #include <companion/model/processing/FeatureMatchingModel.h>
 #include <companion/util/CompanionException.h>
-#include <omp.h>
+#include <companion/thread/TaskPool.h>
 
 namespace Companion {
 	namespace Processing {
@@ -73,6 +73,18 @@ namespace Companion {
 				 */
 				void ClearModels();
 
+				/**
+				 * Get task pool which verifies the hash results in parallel.
+				 * @return Task pool of this recognition.
+				 */
+				PTR_TASK_POOL TaskPool() const;
+
+				/**
+				 * Set task pool which verifies the hash results in parallel.
+				 * @param taskPool Task pool to use. If taskPool is nullptr the shared task pool of the library will be used.
+				 */
+				void TaskPool(PTR_TASK_POOL taskPool);
+
 				/**
 				 * Try to recognize all objects in the given frame.
 				 * @param frame Frame to check for an object location.
@@ -102,6 +114,11 @@ namespace Companion {
 				 */
 				std::map<int, PTR_MODEL_FEATURE_MATCHING> models;
 
+				/**
+				 * Task pool to verify the hash results in parallel.
+				 */
+				PTR_TASK_POOL taskPool;
+
 				/**
 				 * Processing method to recognize objects.
 				 * @param hashResult Result from hash recognition.
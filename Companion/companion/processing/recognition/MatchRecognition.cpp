@@ -19,126 +19,331 @@
 #include "MatchRecognition.h"
 
 Companion::Processing::Recognition::MatchRecognition::MatchRecognition(PTR_MATCHING_RECOGNITION matchingAlgo,
-    Companion::SCALING scaling,
+    Companion::ScalingPolicy scaling,
 	PTR_SHAPE_DETECTION shapeDetection)
 {
     this->matchingAlgo = matchingAlgo;
     this->scaling = scaling;
     this->shapeDetection = shapeDetection;
+    this->taskPool = Thread::TaskPool::Default();
+    this->useDescriptorIndex = false;
+    this->descriptorIndex = nullptr;
+    this->trackingContext = std::make_shared<TRACKING_CONTEXT>();
+    this->useCoarseToFine = false;
+    this->coarseScaling = Companion::ScalingPolicy(Companion::SCALING::SCALE_640x360);
 }
 
 CALLBACK_RESULT Companion::Processing::Recognition::MatchRecognition::Execute(cv::Mat frame)
 {
     CALLBACK_RESULT results;
-    std::vector<CALLBACK_RESULT> parallelizedResults;
+    std::vector<CALLBACK_RESULT> modelResults;
 	PTR_FEATURE_MATCHING featureMatching;
 	PTR_MODEL_FEATURE_MATCHING sceneModel = std::make_shared<MODEL_FEATURE_MATCHING>();;
     std::vector<PTR_DRAW_FRAME> rois;
-    std::vector<Companion::Error::Code> errors;
-    int oldX, oldY, threads;
-
-    // Create vector result list to parallelize
-    if (this->matchingAlgo->IsCuda())
-    {
-        threads = 1;
-        parallelizedResults = std::vector<CALLBACK_RESULT>(threads);
-    }
-    else
-    {
-        threads = omp_get_max_threads();
-        parallelizedResults = std::vector<CALLBACK_RESULT>(threads);
-    }
+    cv::Mat sceneGray;
+    bool precalculate = true;
+    int oldX, oldY;
 
     if (!frame.empty())
     {
         oldX = frame.cols;
         oldY = frame.rows;
 
-        // Shrink the image with a given scale factor or a given output width. Use this list for good 16:9 image sizes:
-        // https://antifreezedesign.wordpress.com/2011/05/13/permutations-of-1920x1080-for-perfect-scaling-at-1-77/
-        Util::ResizeImage(frame, this->scaling);
+        // Shrink the image with the scaling policy, frames which have their target size already are not copied
+        this->scaling.Resize(frame);
         sceneModel->Image(frame);
 
         featureMatching = std::dynamic_pointer_cast<FEATURE_MATCHING>(this->matchingAlgo);
-        if (featureMatching != nullptr)
-        {
-            // Matching algorithm is feature matching
-            // Pre calculate full image scene model keypoints
-            featureMatching->CalculateKeyPoints(sceneModel);
-        }
 
-        if (this->shapeDetection != nullptr)
-        {
-            // If shape detection should be used obtain all possible ROIs from frame
-            rois = this->shapeDetection->ExecuteAlgorithm(sceneModel->Image());
-        }
+        // Each model stores its results in its own list so that results keep the model order
+        modelResults = std::vector<CALLBACK_RESULT>(this->models.size());
 
-        if (this->matchingAlgo->IsCuda())
+        if (featureMatching != nullptr && featureMatching->TrackingInterval() > 0 && !featureMatching->IsCuda() && !this->useDescriptorIndex)
         {
-            for (size_t x = 0; x < models.size(); x++)
+            // Frame is converted once for the optical flow of all tracked models
+            if (frame.channels() > 1)
             {
-                Processing(sceneModel,
-                    models.at(x),
-                    rois,
-                    frame,
-                    oldX,
-                    oldY,
-                    parallelizedResults[omp_get_thread_num()]);
+                Util::ConvertColor(frame, sceneGray, ColorFormat::GRAY);
             }
+            else
+            {
+                sceneGray = frame;
+            }
+
+            // Full frame keypoints are not needed if all models are tracked
+            precalculate = std::any_of(this->models.begin(), this->models.end(), [&](const PTR_MODEL_FEATURE_MATCHING& model)
+            {
+                PTR_TRACKING_STATE state = this->trackingContext->State(model);
+                std::lock_guard<std::mutex> lk(state->Mutex());
+                PTR_OBJECT_TRACK track = state->Track();
+                return !track->IsTracking() || track->Frames() >= featureMatching->TrackingInterval();
+            });
+        }
+
+        if (this->useCoarseToFine && featureMatching != nullptr && !featureMatching->IsCuda() && this->shapeDetection == nullptr)
+        {
+            // Full frame keypoints are not calculated, only the areas around candidates are searched
+            CoarseProcessing(featureMatching, sceneModel, frame, sceneGray, oldX, oldY, modelResults);
         }
         else
         {
-            errors.clear();
-            #pragma omp parallel for
-            for (int x = 0; x < models.size(); x++)
+            if (featureMatching != nullptr && precalculate)
+            {
+                // Matching algorithm is feature matching
+                // Pre calculate full image scene model keypoints
+                featureMatching->CalculateKeyPoints(sceneModel);
+            }
+
+            if (this->shapeDetection != nullptr)
             {
-                try
+                // If shape detection should be used obtain all possible ROIs from frame
+                rois = this->shapeDetection->ExecuteAlgorithm(sceneModel->Image());
+            }
+
+            if (this->useDescriptorIndex && featureMatching != nullptr && !featureMatching->IsCuda() && rois.empty())
+            {
+                // Single match of the scene against all models
+                modelResults = std::vector<CALLBACK_RESULT>(1);
+                IndexProcessing(featureMatching, sceneModel, frame, oldX, oldY, modelResults[0]);
+            }
+            else if (this->matchingAlgo->IsCuda())
+            {
+                for (size_t x = 0; x < models.size(); x++)
                 {
                     Processing(sceneModel,
                         models.at(x),
                         rois,
                         frame,
+                        sceneGray,
                         oldX,
                         oldY,
-                        parallelizedResults[omp_get_thread_num()]);
-                }
-                catch (Companion::Error::Code errorCode)
-                {
-                    #pragma omp critical
-                    errors.push_back(errorCode);
+                        true,
+                        modelResults[x]);
                 }
             }
-
-            if (!errors.empty())
+            else
             {
-                throw Companion::Error::CompanionException(errors);
+                // Throws Companion::Error::CompanionException with the errors of all models
+                this->taskPool->ParallelFor(static_cast<int>(this->models.size()), [&](int x)
+                {
+                    Processing(sceneModel,
+                        models.at(x),
+                        rois,
+                        frame,
+                        sceneGray,
+                        oldX,
+                        oldY,
+                        true,
+                        modelResults[x]);
+                });
             }
         }
 
         frame.release();
     }
 
-    #pragma omp critical
-    for (int i = 0; i < threads; i++) 
+    for (size_t i = 0; i < modelResults.size(); i++)
     {
-        for (int j = 0; j < parallelizedResults[i].size(); j++) 
+        for (size_t j = 0; j < modelResults[i].size(); j++)
         {
-            results.push_back(parallelizedResults[i].at(j));
+            results.push_back(modelResults[i].at(j));
         }
     }
 
     return results;
 }
 
+void Companion::Processing::Recognition::MatchRecognition::CoarseProcessing(PTR_FEATURE_MATCHING featureMatching,
+    PTR_MODEL_FEATURE_MATCHING sceneModel,
+    cv::Mat frame,
+    const cv::Mat& sceneGray,
+    int originalX,
+    int originalY,
+    std::vector<CALLBACK_RESULT>& modelResults)
+{
+    PTR_MODEL_FEATURE_MATCHING coarseModel = std::make_shared<MODEL_FEATURE_MATCHING>();
+    cv::Mat coarseFrame = frame;
+
+    // Resize allocates a new image, the frame itself is not changed
+    this->coarseScaling.Resize(coarseFrame);
+    coarseModel->Image(coarseFrame);
+    featureMatching->CalculateKeyPoints(coarseModel);
+
+    // Throws Companion::Error::CompanionException with the errors of all models
+    this->taskPool->ParallelFor(static_cast<int>(this->models.size()), [&](int x)
+    {
+        PTR_MODEL_FEATURE_MATCHING model = this->models.at(x);
+        PTR_TRACKING_STATE state = this->trackingContext->State(model);
+        std::vector<PTR_RESULT_RECOGNITION> candidates;
+        std::vector<cv::Rect> areas;
+        std::vector<PTR_DRAW_FRAME> rois;
+        std::vector<cv::Point2f> corners;
+        PTR_DRAW_FRAME candidate;
+        cv::Rect area;
+        float scaleX = static_cast<float>(frame.cols) / coarseFrame.cols;
+        float scaleY = static_cast<float>(frame.rows) / coarseFrame.rows;
+        bool merged;
+        bool recognized;
+
+        {
+            // Other consumers of this stream update the state, Processing locks it again
+            std::lock_guard<std::mutex> lk(state->Mutex());
+            recognized = state->Ira()->IsObjectRecognized() || (!sceneGray.empty() && state->Track()->IsTracking());
+        }
+
+        if (recognized)
+        {
+            // Object was recognized in the last frame, it is tracked or IRA searches its area in the frame directly
+            Processing(sceneModel, model, rois, frame, sceneGray, originalX, originalY, true, modelResults[x]);
+            return;
+        }
+
+        candidates = featureMatching->FindCandidates(coarseModel, model);
+        for (const PTR_RESULT_RECOGNITION& result : candidates)
+        {
+            candidate = std::dynamic_pointer_cast<DRAW_FRAME>(result->Drawable());
+            if (candidate == nullptr)
+            {
+                continue;
+            }
+
+            // Candidate position in the frame, enlarged like an IRA area
+            corners = {
+                cv::Point2f(candidate->TopLeft().x * scaleX, candidate->TopLeft().y * scaleY),
+                cv::Point2f(candidate->TopRight().x * scaleX, candidate->TopRight().y * scaleY),
+                cv::Point2f(candidate->BottomRight().x * scaleX, candidate->BottomRight().y * scaleY),
+                cv::Point2f(candidate->BottomLeft().x * scaleX, candidate->BottomLeft().y * scaleY)
+            };
+            area = Algorithm::Recognition::Matching::IRA::SearchArea(corners, frame.size());
+            if (area.area() <= 0)
+            {
+                continue;
+            }
+
+            // Overlapping areas are searched once
+            do
+            {
+                merged = false;
+                for (size_t i = 0; i < areas.size(); i++)
+                {
+                    if ((areas[i] & area).area() > 0)
+                    {
+                        area |= areas[i];
+                        areas.erase(areas.begin() + i);
+                        merged = true;
+                        break;
+                    }
+                }
+            } while (merged);
+            areas.push_back(area);
+        }
+
+        for (const cv::Rect& searchArea : areas)
+        {
+            rois.push_back(std::make_shared<DRAW_FRAME>(searchArea.tl(),
+                cv::Point(searchArea.br().x, searchArea.y),
+                cv::Point(searchArea.x, searchArea.br().y),
+                searchArea.br()));
+        }
+
+        if (!rois.empty())
+        {
+            // Refine candidates in the frame, candidates which are not confirmed do not search the full frame
+            Processing(sceneModel, model, rois, frame, sceneGray, originalX, originalY, false, modelResults[x]);
+        }
+    });
+}
+
+void Companion::Processing::Recognition::MatchRecognition::IndexProcessing(PTR_FEATURE_MATCHING featureMatching,
+    PTR_MODEL_FEATURE_MATCHING sceneModel,
+    cv::Mat frame,
+    int originalX,
+    int originalY,
+    CALLBACK_RESULT& results)
+{
+    PTR_DESCRIPTOR_INDEX index = DescriptorIndex(featureMatching);
+    std::vector<std::vector<cv::DMatch>> modelMatches;
+    std::vector<int> candidates;
+    std::vector<PTR_RESULT> candidateResults;
+
+    featureMatching->MatchIndex(index, sceneModel, modelMatches);
+
+    // Only models with enough votes are verified
+    for (size_t x = 0; x < modelMatches.size(); x++)
+    {
+        if (static_cast<int>(modelMatches[x].size()) >= featureMatching->CountMatches())
+        {
+            candidates.push_back(static_cast<int>(x));
+        }
+    }
+
+    candidateResults = std::vector<PTR_RESULT>(candidates.size());
+    this->taskPool->ParallelFor(static_cast<int>(candidates.size()), [&](int x)
+    {
+        int model = candidates.at(x);
+        candidateResults[x] = featureMatching->VerifyMatches(sceneModel, index->Models().at(model), modelMatches[model]);
+    });
+
+    for (PTR_RESULT& result : candidateResults)
+    {
+        if (result != nullptr)
+        {
+            // Create old image size
+            result->Drawable()->Ratio(frame.cols, frame.rows, originalX, originalY);
+            results.push_back(result);
+        }
+    }
+}
+
+PTR_DESCRIPTOR_INDEX Companion::Processing::Recognition::MatchRecognition::DescriptorIndex(PTR_FEATURE_MATCHING featureMatching)
+{
+    std::lock_guard<std::mutex> lk(this->indexMx);
+
+    if (this->descriptorIndex == nullptr)
+    {
+        // Prepare models in parallel before they are indexed
+        this->taskPool->ParallelFor(static_cast<int>(this->models.size()), [&](int x)
+        {
+            featureMatching->PrepareModel(this->models.at(x));
+        });
+        this->descriptorIndex = featureMatching->CreateIndex(this->models);
+    }
+
+    return this->descriptorIndex;
+}
+
+bool Companion::Processing::Recognition::MatchRecognition::CoarseToFine() const
+{
+    return this->useCoarseToFine;
+}
+
+void Companion::Processing::Recognition::MatchRecognition::CoarseToFine(bool useCoarseToFine, Companion::ScalingPolicy coarseScaling)
+{
+    this->useCoarseToFine = useCoarseToFine;
+    this->coarseScaling = coarseScaling;
+}
+
+void Companion::Processing::Recognition::MatchRecognition::UseDescriptorIndex(bool useDescriptorIndex)
+{
+    this->useDescriptorIndex = useDescriptorIndex;
+}
+
 void Companion::Processing::Recognition::MatchRecognition::Processing(PTR_MODEL_FEATURE_MATCHING sceneModel,
 	PTR_MODEL_FEATURE_MATCHING objectModel,
     std::vector<PTR_DRAW_FRAME> rois,
     cv::Mat frame,
+    const cv::Mat& sceneGray,
     int originalX,
     int originalY,
+    bool searchScene,
     CALLBACK_RESULT &results)
 {
-	PTR_RESULT result = nullptr;
+    std::vector<PTR_RESULT_RECOGNITION> instances;
+    std::vector<PTR_RESULT_RECOGNITION> roiInstances;
+    PTR_FEATURE_MATCHING featureMatching;
+    PTR_RESULT_RECOGNITION tracked;
+    PTR_RESULT_RECOGNITION iraResult;
+    PTR_TRACKING_STATE state;
 
     if (!objectModel)
     {
@@ -146,37 +351,57 @@ void Companion::Processing::Recognition::MatchRecognition::Processing(PTR_MODEL_
         throw Companion::Error::Code::wrong_model_type;
     }
 
-    if (rois.size() == 0)
+    // State of the model in this stream, frames of one stream can be processed by several threads
+    state = this->trackingContext->State(objectModel);
+    std::lock_guard<std::mutex> lk(state->Mutex());
+
+    if (!sceneGray.empty())
+    {
+        // Tracked objects are followed without feature matching
+        featureMatching = std::dynamic_pointer_cast<FEATURE_MATCHING>(this->matchingAlgo);
+        tracked = featureMatching->TrackObject(sceneGray, objectModel, state);
+    }
+
+    if (tracked != nullptr)
     {
-        try 
+        instances.push_back(tracked);
+    }
+    else if (rois.size() == 0)
+    {
+        // If ROIs not found or used
+        instances = this->matchingAlgo->FindInstances(sceneModel, objectModel, nullptr, state);
+    }
+    else
+    {
+        featureMatching = std::dynamic_pointer_cast<FEATURE_MATCHING>(this->matchingAlgo);
+        if (featureMatching != nullptr)
         {
-            // If ROIs not found or used
-            result = std::shared_ptr<RESULT>(this->matchingAlgo->ExecuteAlgorithm(sceneModel, objectModel, nullptr));
+            // Area of the last recognition is searched once before the ROIs
+            iraResult = featureMatching->SearchIRA(sceneModel, objectModel, state);
         }
-        catch (Companion::Error::Code errorCode)
+
+        if (iraResult != nullptr)
         {
-            throw errorCode;
+            instances.push_back(iraResult);
         }
-    }
-    else
-    {
-        size_t index = 0;
-        // If ROIs found
-        while (index < rois.size())
+        else
         {
-            try 
-            {
-                result = std::shared_ptr<RESULT>(this->matchingAlgo->ExecuteAlgorithm(sceneModel, objectModel, rois.at(index)));
-            }
-            catch (Companion::Error::Code errorCode)
+            // If ROIs found, results of all ROIs are kept
+            for (const PTR_DRAW_FRAME& roi : rois)
             {
-                throw errorCode;
+                roiInstances = this->matchingAlgo->FindInstances(sceneModel, objectModel, roi, state);
+                instances.insert(instances.end(), roiInstances.begin(), roiInstances.end());
             }
-            index++;
+        }
+
+        if (instances.empty() && searchScene)
+        {
+            // Full scene is searched at most once per frame if the object is in none of the ROIs
+            instances = this->matchingAlgo->FindInstances(sceneModel, objectModel, nullptr, state);
         }
     }
 
-    if (result != nullptr)
+    for (const PTR_RESULT_RECOGNITION& result : instances)
     {
         // Create old image size
         result->Drawable()->Ratio(frame.cols, frame.rows, originalX, originalY);
@@ -191,18 +416,85 @@ bool Companion::Processing::Recognition::MatchRecognition::AddModel(PTR_MODEL_FE
     if (!model->Image().empty())
     {
         this->models.push_back(model);
+        ResetDescriptorIndex();
         return true;
     }
 
     return false;
 }
 
+int Companion::Processing::Recognition::MatchRecognition::AddModels(const std::vector<PTR_MODEL_FEATURE_MATCHING>& models,
+    std::function<PROGRESS_CALLBACK> progress)
+{
+    PTR_FEATURE_MATCHING featureMatching = std::dynamic_pointer_cast<FEATURE_MATCHING>(this->matchingAlgo);
+
+    return PrepareModels(models, [featureMatching](PTR_MODEL_FEATURE_MATCHING model)
+    {
+        if (featureMatching != nullptr)
+        {
+            featureMatching->PrepareModel(model);
+        }
+    }, progress);
+}
+
+int Companion::Processing::Recognition::MatchRecognition::AddModels(const std::vector<PTR_MODEL_FEATURE_MATCHING>& models,
+    cv::Ptr<cv::FeatureDetector> detector,
+    cv::Ptr<cv::DescriptorExtractor> extractor,
+    std::function<PROGRESS_CALLBACK> progress)
+{
+    return PrepareModels(models, [detector, extractor](PTR_MODEL_FEATURE_MATCHING model)
+    {
+        // Models can be shared between streams, keypoints are calculated once
+        model->Prepare([&]()
+        {
+            model->CalculateKeyPointsAndDescriptors(detector, extractor);
+        });
+    }, progress);
+}
+
+int Companion::Processing::Recognition::MatchRecognition::PrepareModels(const std::vector<PTR_MODEL_FEATURE_MATCHING>& models,
+    std::function<void(PTR_MODEL_FEATURE_MATCHING)> prepare,
+    std::function<PROGRESS_CALLBACK> progress)
+{
+    std::vector<PTR_MODEL_FEATURE_MATCHING> validModels;
+    std::mutex progressMx;
+    int prepared = 0;
+
+    for (const PTR_MODEL_FEATURE_MATCHING& model : models)
+    {
+        if (model != nullptr && !model->Image().empty())
+        {
+            validModels.push_back(model);
+        }
+    }
+
+    // Throws Companion::Error::CompanionException with the errors of all models
+    this->taskPool->ParallelFor(static_cast<int>(validModels.size()), [&](int x)
+    {
+        prepare(validModels.at(x));
+
+        if (progress)
+        {
+            // Progress is reported in order and never concurrently
+            std::lock_guard<std::mutex> lk(progressMx);
+            prepared++;
+            progress(prepared, static_cast<int>(validModels.size()));
+        }
+    });
+
+    this->models.insert(this->models.end(), validModels.begin(), validModels.end());
+    ResetDescriptorIndex();
+    return static_cast<int>(validModels.size());
+}
+
 bool Companion::Processing::Recognition::MatchRecognition::RemoveModel(int modelID)
 {
     for (size_t index = 0; index < this->models.size(); index++)
     {
         if (this->models.at(index)->ID() == modelID) {
+            this->trackingContext->Remove(this->models.at(index));
             this->models.erase(this->models.begin() + index);
+            ResetDescriptorIndex();
             return true;
         }
     }
@@ -212,4 +504,28 @@ bool Companion::Processing::Recognition::MatchRecognition::RemoveModel(int model
 void Companion::Processing::Recognition::MatchRecognition::ClearModels()
 {
     this->models.clear();
+    this->trackingContext->Clear();
+    ResetDescriptorIndex();
+}
+
+void Companion::Processing::Recognition::MatchRecognition::ResetDescriptorIndex()
+{
+    std::lock_guard<std::mutex> lk(this->indexMx);
+    this->descriptorIndex = nullptr;
+}
+
+PTR_TASK_POOL Companion::Processing::Recognition::MatchRecognition::TaskPool() const
+{
+    return this->taskPool;
+}
+
+void Companion::Processing::Recognition::MatchRecognition::TaskPool(PTR_TASK_POOL taskPool)
+{
+
+    if (taskPool == nullptr)
+    {
+        taskPool = Thread::TaskPool::Default();
+    }
+
+    this->taskPool = taskPool;
 }
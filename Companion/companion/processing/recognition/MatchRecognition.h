@@ -19,22 +19,29 @@
 #ifndef COMPANION_MATCHRECOGNITION_H
 #define COMPANION_MATCHRECOGNITION_H
 
+#include <algorithm>
+#include <mutex>
+#include <functional>
 #include <opencv2/core/core.hpp>
 #include <companion/processing/ImageProcessing.h>
 #include <companion/model/processing/FeatureMatchingModel.h>
 #include <companion/draw/Drawable.h>
 #include <companion/util/CompanionException.h>
 #include <companion/algo/recognition/matching/FeatureMatching.h>
+#include <companion/algo/recognition/matching/util/TrackingContext.h>
 #include <companion/algo/detection/ShapeDetection.h>
+#include <companion/thread/TaskPool.h>
 #include <companion/Configuration.h>
-#include <omp.h>
+#include <companion/util/ScalingPolicy.h>
 
 namespace Companion {
 	namespace Processing {
 		namespace Recognition
 		{
 			/**
-			 * Match recognition implementation to recognize objects based on matching algorithms.
+			 * Match recognition implementation to recognize objects based on matching algorithms. Each recognition
+			 * stores IRA positions and tracks of its models in its own tracking context, so models can be shared
+			 * between recognitions of several streams.
 			 * @author Andreas Sekulski, Dimitri Kotlovsky
 			 */
 			class COMP_EXPORTS MatchRecognition : public ImageProcessing
@@ -45,11 +52,11 @@ namespace Companion {
 				/**
 				 * Match recognition constructor.
 				 * @param matchingAlgo Matching algorithm to use, for example feature matching.
-				 * @param scaling Scaling to resize an image. Default is 1920x1080.
+				 * @param scaling Scaling policy to resize an image. Default fits images into 1920x1080 without upscaling.
 				 * @param shapeDetection Shape detection algorithm to detect ROI's in images (if not set the whole image will be searched).
 				 */
 				MatchRecognition(PTR_MATCHING_RECOGNITION matchingAlgo,
-					Companion::SCALING scaling = Companion::SCALING::SCALE_1920x1080,
+					Companion::ScalingPolicy scaling = Companion::SCALING::SCALE_1920x1080,
 					PTR_SHAPE_DETECTION shapeDetection = nullptr);
 
 				/**
@@ -64,6 +71,35 @@ namespace Companion {
 				 */
 				bool AddModel(PTR_MODEL_FEATURE_MATCHING model);
 
+				/**
+				 * Add several search models and prepare them in parallel before they are searched for. If feature
+				 * matching is used, keypoints and descriptors are loaded from its feature cache or calculated with its
+				 * detector and extractor, so the first frames are not delayed by model preparation.
+				 * @param models Models to search for, models without image are not added.
+				 * @param progress Optional callback with the number of prepared models and the number of all models,
+				 * called from the task pool threads but never concurrently.
+				 * @throws Companion::Error::CompanionException if models could not be prepared, no model is added in this case.
+				 * @return Number of added models.
+				 */
+				int AddModels(const std::vector<PTR_MODEL_FEATURE_MATCHING>& models,
+					std::function<PROGRESS_CALLBACK> progress = nullptr);
+
+				/**
+				 * Add several search models and calculate their keypoints and descriptors in parallel with the given
+				 * detector and extractor, which must match the ones of the feature matching algorithm.
+				 * @param models Models to search for, models without image are not added.
+				 * @param detector Feature detector to calculate keypoints.
+				 * @param extractor Descriptor extractor to calculate descriptors.
+				 * @param progress Optional callback with the number of prepared models and the number of all models,
+				 * called from the task pool threads but never concurrently.
+				 * @throws Companion::Error::CompanionException if models could not be prepared, no model is added in this case.
+				 * @return Number of added models.
+				 */
+				int AddModels(const std::vector<PTR_MODEL_FEATURE_MATCHING>& models,
+					cv::Ptr<cv::FeatureDetector> detector,
+					cv::Ptr<cv::DescriptorExtractor> extractor,
+					std::function<PROGRESS_CALLBACK> progress = nullptr);
+
 				/**
 				 * Remove given model if it exists. This method can only be used safely if the searching process is not running.
 				 * @param modelID ID of the model to remove.
@@ -76,6 +112,44 @@ namespace Companion {
 				 */
 				void ClearModels();
 
+				/**
+				 * Set to disable or enable the descriptor index mode. If enabled, the scene is matched once per frame
+				 * against one index of all model descriptors and only models with enough matches are verified. Used for
+				 * feature matching without cuda if no ROIs are detected, IRA is not used in this mode.
+				 * @param useDescriptorIndex Use a descriptor index of all models.
+				 */
+				void UseDescriptorIndex(bool useDescriptorIndex);
+
+				/**
+				 * Indicator if the coarse to fine mode is used.
+				 * @return True if the coarse to fine mode is used otherwise false.
+				 */
+				bool CoarseToFine() const;
+
+				/**
+				 * Set to disable or enable the coarse to fine mode. If enabled, models are searched first in the frame
+				 * resized to the coarse scaling. Only the areas around found candidates are searched again in the frame
+				 * resized to the scaling of this recognition, so frames without objects are only searched at the coarse
+				 * scaling. Models with a recognized IRA position are searched in their IRA area directly. Used for feature
+				 * matching without cuda and without shape detection.
+				 * @param useCoarseToFine Use the coarse to fine mode.
+				 * @param coarseScaling Scaling policy of the coarse search. Default fits images into 640x360.
+				 */
+				void CoarseToFine(bool useCoarseToFine, Companion::ScalingPolicy coarseScaling = Companion::SCALING::SCALE_640x360);
+
+				/**
+				 * Get task pool which executes the models in parallel.
+				 * @return Task pool of this recognition.
+				 */
+				PTR_TASK_POOL TaskPool() const;
+
+				/**
+				 * Set task pool which executes the models in parallel. Recognitions of several streams can share one
+				 * task pool to limit the number of threads.
+				 * @param taskPool Task pool to use. If taskPool is nullptr the shared task pool of the library will be used.
+				 */
+				void TaskPool(PTR_TASK_POOL taskPool);
+
 				/**
 				 * Try to recognize all objects in the given frame.
 				 * @param frame Frame to check for an object location.
@@ -86,9 +160,19 @@ namespace Companion {
 			private:
 
 				/**
-				 * Scaling value to resize image.
+				 * Scaling policy to resize image.
+				 */
+				Companion::ScalingPolicy scaling;
+
+				/**
+				 * Scaling policy to resize image for the coarse search.
+				 */
+				Companion::ScalingPolicy coarseScaling;
+
+				/**
+				 * Indicator to use the coarse to fine mode.
 				 */
-				Companion::SCALING scaling;
+				bool useCoarseToFine;
 
 				/**
 				 * Matching algorithm.
@@ -106,21 +190,110 @@ namespace Companion {
 				std::vector<PTR_MODEL_FEATURE_MATCHING> models;
 
 				/**
-				 * Processing method to recognize objects.
+				 * Task pool to execute the models in parallel.
+				 */
+				PTR_TASK_POOL taskPool;
+
+				/**
+				 * Tracking context with IRA positions and tracks of all models in the stream of this recognition.
+				 */
+				PTR_TRACKING_CONTEXT trackingContext;
+
+				/**
+				 * Indicator to use a descriptor index of all models.
+				 */
+				bool useDescriptorIndex;
+
+				/**
+				 * Descriptor index of all models, created on the first frame after the models have changed.
+				 */
+				PTR_DESCRIPTOR_INDEX descriptorIndex;
+
+				/**
+				 * Mutex to lock the creation of the descriptor index.
+				 */
+				std::mutex indexMx;
+
+				/**
+				 * Get the descriptor index of all models, create it if the models have changed.
+				 * @param featureMatching Feature matching to create the index.
+				 * @return Descriptor index of all models.
+				 */
+				PTR_DESCRIPTOR_INDEX DescriptorIndex(PTR_FEATURE_MATCHING featureMatching);
+
+				/**
+				 * Release the descriptor index because the models have changed.
+				 */
+				void ResetDescriptorIndex();
+
+				/**
+				 * Recognize objects by matching the scene once against the descriptor index of all models.
+				 * @param featureMatching Feature matching to match and verify the models.
+				 * @param sceneModel Scene model with calculated keypoints and descriptors.
+				 * @param frame Scene frame.
+				 * @param originalX Original width of the scene frame.
+				 * @param originalY Original height of the scene frame.
+				 * @param results List of all recognized objects.
+				 */
+				void IndexProcessing(PTR_FEATURE_MATCHING featureMatching,
+					PTR_MODEL_FEATURE_MATCHING sceneModel,
+					cv::Mat frame,
+					int originalX,
+					int originalY,
+					CALLBACK_RESULT& results);
+
+				/**
+				 * Recognize objects by searching candidates in the frame resized to the coarse scaling and by searching
+				 * the areas around the candidates in the frame.
+				 * @param featureMatching Feature matching to search the candidates.
+				 * @param sceneModel Scene model of the frame without calculated keypoints.
+				 * @param frame Scene frame.
+				 * @param sceneGray Grayscale scene frame to track objects, empty if objects are not tracked.
+				 * @param originalX Original width of the scene frame.
+				 * @param originalY Original height of the scene frame.
+				 * @param modelResults List of recognized objects of each model.
+				 */
+				void CoarseProcessing(PTR_FEATURE_MATCHING featureMatching,
+					PTR_MODEL_FEATURE_MATCHING sceneModel,
+					cv::Mat frame,
+					const cv::Mat& sceneGray,
+					int originalX,
+					int originalY,
+					std::vector<CALLBACK_RESULT>& modelResults);
+
+				/**
+				 * Prepare models in parallel and add them.
+				 * @param models Models to add, models without image are not added.
+				 * @param prepare Preparation of a single model.
+				 * @param progress Optional progress callback.
+				 * @return Number of added models.
+				 */
+				int PrepareModels(const std::vector<PTR_MODEL_FEATURE_MATCHING>& models,
+					std::function<void(PTR_MODEL_FEATURE_MATCHING)> prepare,
+					std::function<PROGRESS_CALLBACK> progress);
+
+				/**
+				 * Processing method to recognize objects. Results of all instances of the object in all ROIs are stored.
+				 * A tracked object is followed into the frame instead if possible. If ROIs are given, the IRA area of
+				 * the last recognition is searched first, then all ROIs and at last the full scene once.
 				 * @param sceneModel Scene model to check.
 				 * @param objectModel Object model to search in scene.
 				 * @param rois List of ROIs if existent.
 				 * @param frame Scene frame.
+				 * @param sceneGray Grayscale scene frame to track objects, empty if objects are not tracked.
 				 * @param originalX Original width of the scene frame.
 				 * @param originalY Original height of the scene frame.
+				 * @param searchScene Search the full scene if the object is found in none of the ROIs.
 				 * @param results List of all recognized objects.
 				 */
 				void Processing(PTR_MODEL_FEATURE_MATCHING sceneModel,
 					PTR_MODEL_FEATURE_MATCHING objectModel,
 					std::vector<PTR_DRAW_FRAME> rois,
 					cv::Mat frame,
+					const cv::Mat& sceneGray,
 					int originalX,
 					int originalY,
+					bool searchScene,
 					CALLBACK_RESULT& results);
 			};
 		}
@@ -0,0 +1,383 @@
+/*
+ * This program is an object recognition framework written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_RINGBUFFER_H
+#define COMPANION_RINGBUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace Companion {
+	namespace Thread
+	{
+		/**
+		 * Wait policies for threads which have to wait for a ring buffer.
+		 */
+		enum class WaitPolicy
+		{
+			BLOCKING, ///< Waiting threads are parked until they are notified.
+			NON_BLOCKING ///< Waiting threads spin and yield their time slice, lowest latency but busy CPU cores.
+		};
+
+		/**
+		 * Bounded and preallocated lock-free ring buffer for a single producer. Each slot has its own sequence number so
+		 * that items can be taken by one or more consumers without locks. Producer and consumer positions are stored in
+		 * separate cache lines to avoid false sharing.
+		 * @author Andreas Sekulski, Dimitri Kotlovsky
+		 */
+		template<typename T>
+		class RingBuffer
+		{
+
+		public:
+
+			/**
+			 * Constructor to create a ring buffer with a fixed capacity.
+			 * @param capacity Maximum number of items in the buffer. If capacity <= 0 the capacity is one item.
+			 * @param waitPolicy Wait policy for threads which are waiting in Push() or Pop().
+			 */
+			RingBuffer(int capacity, WaitPolicy waitPolicy = WaitPolicy::BLOCKING);
+
+			/**
+			 * Default destructor.
+			 */
+			~RingBuffer() = default;
+
+			/**
+			 * Store the given item if the buffer has free space. Must only be called by the producer.
+			 * @param item Item to store. The item is moved to the buffer if it was stored.
+			 * @return <code>True</code> if the item was stored, <code>false</code> if the buffer is full.
+			 */
+			bool TryPush(T& item);
+
+			/**
+			 * Store the given item and wait for free space if the buffer is full. Must only be called by the producer.
+			 * @param item Item to store.
+			 * @return <code>True</code> if the item was stored, <code>false</code> if the buffer was closed.
+			 */
+			bool Push(T item);
+
+			/**
+			 * Take the oldest item if the buffer is not empty.
+			 * @param item Item which was taken from the buffer.
+			 * @return <code>True</code> if an item was taken, <code>false</code> if the buffer is empty.
+			 */
+			bool TryPop(T& item);
+
+			/**
+			 * Take the oldest item and wait for an item if the buffer is empty.
+			 * @param item Item which was taken from the buffer.
+			 * @return <code>True</code> if an item was taken, <code>false</code> if the buffer is closed and empty.
+			 */
+			bool Pop(T& item);
+
+			/**
+			 * Close this buffer. No further items can be stored and all waiting threads are released. Stored items can
+			 * still be taken.
+			 */
+			void Close();
+
+			/**
+			 * Indicator if this buffer is closed.
+			 * @return <code>True</code> if the buffer is closed, <code>false</code> otherwise.
+			 */
+			bool IsClosed() const;
+
+			/**
+			 * Get the number of stored items. The value is only a snapshot if other threads use the buffer.
+			 * @return Number of stored items.
+			 */
+			size_t Size() const;
+
+			/**
+			 * Get the maximum number of items in this buffer.
+			 * @return Capacity of the buffer.
+			 */
+			size_t Capacity() const;
+
+		private:
+
+			/**
+			 * Cache line size in bytes to separate producer and consumer data.
+			 */
+			static constexpr size_t CACHE_LINE_SIZE = 64;
+
+			/**
+			 * Buffer slot to store one item.
+			 */
+			struct Slot
+			{
+				/**
+				 * Sequence number of the slot which indicates if the slot can be written or read.
+				 */
+				std::atomic<size_t> sequence;
+
+				/**
+				 * Stored item.
+				 */
+				T item;
+			};
+
+			/**
+			 * Position of the next item to take, written by consumers in its own cache line.
+			 */
+			alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;
+
+			/**
+			 * Position of the next item to store, written by the producer in its own cache line.
+			 */
+			alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;
+
+			/**
+			 * Preallocated buffer slots, starts a new cache line so that reading the buffer settings does not share
+			 * the line of the producer position.
+			 */
+			alignas(CACHE_LINE_SIZE) std::unique_ptr<Slot[]> slots;
+
+			/**
+			 * Number of buffer slots.
+			 */
+			size_t capacity;
+
+			/**
+			 * Wait policy for waiting threads.
+			 */
+			WaitPolicy waitPolicy;
+
+			/**
+			 * Indicator if this buffer is closed.
+			 */
+			std::atomic<bool> closed;
+
+			/**
+			 * Number of producers which are parked until the buffer has free space.
+			 */
+			std::atomic<int> waitingProducers;
+
+			/**
+			 * Number of consumers which are parked until the buffer has an item.
+			 */
+			std::atomic<int> waitingConsumers;
+
+			/**
+			 * Mutex to park waiting threads.
+			 */
+			std::mutex mx;
+
+			/**
+			 * Condition to wait for free space.
+			 */
+			std::condition_variable notFull;
+
+			/**
+			 * Condition to wait for an item.
+			 */
+			std::condition_variable notEmpty;
+
+			/**
+			 * Wait until the given condition is fulfilled or the waiting thread should check the buffer again.
+			 * @param condition Condition variable to park the thread.
+			 * @param waiting Counter of parked threads for the given condition.
+			 * @param ready Predicate which indicates that the thread can continue.
+			 */
+			template<typename Predicate>
+			void Wait(std::condition_variable& condition, std::atomic<int>& waiting, Predicate ready);
+
+			/**
+			 * Notify threads which are parked on the given condition.
+			 * @param condition Condition variable to notify.
+			 * @param waiting Counter of parked threads for the given condition.
+			 */
+			void Notify(std::condition_variable& condition, std::atomic<int>& waiting);
+		};
+	}
+}
+
+template<typename T>
+Companion::Thread::RingBuffer<T>::RingBuffer(int capacity, WaitPolicy waitPolicy)
+{
+	if (capacity <= 0)
+	{
+		capacity = 1;
+	}
+
+	this->capacity = static_cast<size_t>(capacity);
+	this->waitPolicy = waitPolicy;
+	this->slots = std::unique_ptr<Slot[]>(new Slot[this->capacity]);
+	for (size_t i = 0; i < this->capacity; i++)
+	{
+		this->slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	this->head.store(0, std::memory_order_relaxed);
+	this->tail.store(0, std::memory_order_relaxed);
+	this->closed.store(false);
+	this->waitingProducers.store(0);
+	this->waitingConsumers.store(0);
+}
+
+template<typename T>
+bool Companion::Thread::RingBuffer<T>::TryPush(T& item)
+{
+	size_t position = this->tail.load(std::memory_order_relaxed);
+	Slot& slot = this->slots[position % this->capacity];
+
+	if (slot.sequence.load(std::memory_order_acquire) != position)
+	{
+		// Slot was not released by a consumer yet, buffer is full
+		return false;
+	}
+
+	slot.item = std::move(item);
+	slot.sequence.store(position + 1, std::memory_order_release);
+	this->tail.store(position + 1, std::memory_order_seq_cst);
+	this->Notify(this->notEmpty, this->waitingConsumers);
+	return true;
+}
+
+template<typename T>
+bool Companion::Thread::RingBuffer<T>::Push(T item)
+{
+	while (!this->closed.load())
+	{
+		if (this->TryPush(item))
+		{
+			return true;
+		}
+
+		this->Wait(this->notFull, this->waitingProducers, [this] {
+			return this->closed.load() || this->Size() < this->capacity;
+		});
+	}
+
+	return false;
+}
+
+template<typename T>
+bool Companion::Thread::RingBuffer<T>::TryPop(T& item)
+{
+	size_t position = this->head.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		Slot& slot = this->slots[position % this->capacity];
+		size_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+		if (sequence == position + 1)
+		{
+			// Slot is filled, try to reserve it against other consumers
+			if (this->head.compare_exchange_weak(position, position + 1, std::memory_order_seq_cst))
+			{
+				item = std::move(slot.item);
+				slot.item = T();
+				slot.sequence.store(position + this->capacity, std::memory_order_release);
+				this->Notify(this->notFull, this->waitingProducers);
+				return true;
+			}
+		}
+		else if (sequence == position)
+		{
+			// Slot was not filled by the producer yet, buffer is empty
+			return false;
+		}
+		else
+		{
+			// Another consumer took this slot in the meantime
+			position = this->head.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+template<typename T>
+bool Companion::Thread::RingBuffer<T>::Pop(T& item)
+{
+	while (!this->TryPop(item))
+	{
+		if (this->closed.load() && this->Size() == 0)
+		{
+			return false;
+		}
+
+		this->Wait(this->notEmpty, this->waitingConsumers, [this] {
+			return this->closed.load() || this->Size() > 0;
+		});
+	}
+
+	return true;
+}
+
+template<typename T>
+void Companion::Thread::RingBuffer<T>::Close()
+{
+	std::lock_guard<std::mutex> lk(this->mx);
+	this->closed.store(true);
+	this->notFull.notify_all();
+	this->notEmpty.notify_all();
+}
+
+template<typename T>
+bool Companion::Thread::RingBuffer<T>::IsClosed() const
+{
+	return this->closed.load();
+}
+
+template<typename T>
+size_t Companion::Thread::RingBuffer<T>::Size() const
+{
+	size_t head = this->head.load();
+	size_t tail = this->tail.load();
+	return (tail > head) ? (tail - head) : 0;
+}
+
+template<typename T>
+size_t Companion::Thread::RingBuffer<T>::Capacity() const
+{
+	return this->capacity;
+}
+
+template<typename T>
+template<typename Predicate>
+void Companion::Thread::RingBuffer<T>::Wait(std::condition_variable& condition, std::atomic<int>& waiting, Predicate ready)
+{
+	if (this->waitPolicy == WaitPolicy::NON_BLOCKING)
+	{
+		std::this_thread::yield();
+		return;
+	}
+
+	std::unique_lock<std::mutex> lk(this->mx);
+	waiting.fetch_add(1);
+	condition.wait(lk, ready);
+	waiting.fetch_sub(1);
+}
+
+template<typename T>
+void Companion::Thread::RingBuffer<T>::Notify(std::condition_variable& condition, std::atomic<int>& waiting)
+{
+	if (waiting.load() > 0)
+	{
+		// Lock is needed so a thread can not miss the notification between its check and parking
+		std::lock_guard<std::mutex> lk(this->mx);
+		condition.notify_all();
+	}
+}
+
+#endif //COMPANION_RINGBUFFER_H
@@ -0,0 +1,300 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StreamEngine.h"
+
+Companion::Thread::StreamEngine::StreamEngine(int processingThreads)
+{
+	this->signals = 0;
+	this->cursor = 0;
+	this->nextId = 0;
+	this->terminate = false;
+
+	if (processingThreads <= 0)
+	{
+		processingThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	for (int i = 0; i < processingThreads; i++)
+	{
+		this->threads.push_back(std::thread(&StreamEngine::Process, this));
+	}
+}
+
+Companion::Thread::StreamEngine::~StreamEngine()
+{
+	Stop(ShutdownMode::DISCARD);
+
+	{
+		std::lock_guard<std::mutex> lk(this->mx);
+		this->terminate = true;
+	}
+	this->storedCv.notify_all();
+
+	for (std::thread& thread : this->threads)
+	{
+		thread.join();
+	}
+
+	// Producers use this engine to signal stored frames, so they have to return before it is destroyed
+	for (std::shared_ptr<EngineStream>& stream : this->streams)
+	{
+		if (stream->producer.joinable())
+		{
+			stream->producer.join();
+		}
+	}
+}
+
+int Companion::Thread::StreamEngine::AddStream(PTR_COMPANION configuration)
+{
+	std::shared_ptr<EngineStream> stream = std::make_shared<EngineStream>();
+
+	// Get all configuration data
+	// Throws Error if invalid settings are set.
+	PTR_STREAM source = configuration->Source();
+	int skipFrame = configuration->SkipFrame();
+	stream->processing = configuration->Processing();
+	stream->errorCallback = configuration->ErrorCallback();
+	stream->successCallback = configuration->ResultCallback();
+	stream->worker = configuration->CreateWorker();
+	stream->maxInFlight = configuration->ConsumerThreads();
+	// Frames of this stream are processed by at most so many threads at once
+	stream->worker->Consumers(std::min(stream->maxInFlight, ProcessingThreads()));
+	stream->inFlight = 0;
+	stream->finished = false;
+	stream->worker->StoreCallback([this]()
+	{
+		Signal();
+	});
+
+	RemoveFinished();
+
+	// Producer is started while the stream is registered so that no signal gets lost
+	std::lock_guard<std::mutex> lk(this->mx);
+	stream->id = this->nextId++;
+	this->streams.push_back(stream);
+	stream->producer = std::thread(&StreamWorker::Produce, stream->worker, source, skipFrame, stream->errorCallback);
+
+	return stream->id;
+}
+
+void Companion::Thread::StreamEngine::Stop(int id, ShutdownMode mode)
+{
+	FindStream(id)->worker->Stop(mode);
+}
+
+void Companion::Thread::StreamEngine::Stop(ShutdownMode mode)
+{
+	std::vector<std::shared_ptr<EngineStream>> streams;
+
+	{
+		std::lock_guard<std::mutex> lk(this->mx);
+		streams = this->streams;
+	}
+
+	// Workers signal the engine if stopped, so the lock must be released
+	for (std::shared_ptr<EngineStream>& stream : streams)
+	{
+		stream->worker->Stop(mode);
+	}
+}
+
+void Companion::Thread::StreamEngine::Wait()
+{
+	std::unique_lock<std::mutex> lk(this->mx);
+
+	this->finishedCv.wait(lk, [this]()
+	{
+		return std::all_of(this->streams.begin(), this->streams.end(), [](const std::shared_ptr<EngineStream>& stream)
+		{
+			return stream->finished.load();
+		});
+	});
+
+	lk.unlock();
+	RemoveFinished();
+}
+
+Companion::Thread::StreamStatistics Companion::Thread::StreamEngine::Statistics(int id) const
+{
+	return FindStream(id)->worker->Statistics();
+}
+
+int Companion::Thread::StreamEngine::Streams() const
+{
+	std::lock_guard<std::mutex> lk(this->mx);
+
+	return static_cast<int>(std::count_if(this->streams.begin(), this->streams.end(), [](const std::shared_ptr<EngineStream>& stream)
+	{
+		return !stream->finished.load();
+	}));
+}
+
+int Companion::Thread::StreamEngine::ProcessingThreads() const
+{
+	return static_cast<int>(this->threads.size());
+}
+
+void Companion::Thread::StreamEngine::Process()
+{
+
+	while (true)
+	{
+
+		if (ProcessNext())
+		{
+			continue;
+		}
+
+		// No stream has a frame to process, park until the next frame is stored
+		std::unique_lock<std::mutex> lk(this->mx);
+		this->storedCv.wait(lk, [this]()
+		{
+			return this->terminate || this->signals > 0;
+		});
+
+		if (this->terminate)
+		{
+			break;
+		}
+
+		this->signals--;
+	}
+}
+
+bool Companion::Thread::StreamEngine::ProcessNext()
+{
+	std::vector<std::shared_ptr<EngineStream>> streams;
+	std::shared_ptr<EngineStream> stream;
+	size_t start;
+	bool consumed;
+
+	{
+		std::lock_guard<std::mutex> lk(this->mx);
+
+		if (this->streams.empty())
+		{
+			return false;
+		}
+
+		// Each search starts at the next stream so that every stream gets its turn
+		streams = this->streams;
+		start = this->cursor++;
+	}
+
+	for (size_t i = 0; i < streams.size(); i++)
+	{
+		stream = streams[(start + i) % streams.size()];
+
+		if (stream->finished)
+		{
+			continue;
+		}
+
+		consumed = false;
+		if (++stream->inFlight <= stream->maxInFlight)
+		{
+			consumed = stream->worker->TryConsume(stream->processing, stream->errorCallback, stream->successCallback);
+		}
+		stream->inFlight--;
+
+		CheckFinished(stream);
+
+		if (consumed)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Companion::Thread::StreamEngine::Signal()
+{
+
+	{
+		std::lock_guard<std::mutex> lk(this->mx);
+
+		// More wake ups than threads are not necessary, threads search all streams after waking up
+		if (this->signals < static_cast<int>(this->threads.size()))
+		{
+			this->signals++;
+		}
+	}
+
+	this->storedCv.notify_one();
+}
+
+void Companion::Thread::StreamEngine::CheckFinished(std::shared_ptr<EngineStream> stream)
+{
+
+	if (stream->finished || !stream->worker->IsClosed() || stream->worker->BufferedFrames() > 0 || stream->inFlight > 0)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(this->mx);
+		stream->finished = true;
+	}
+	stream->worker->Consumers(0);
+
+	this->finishedCv.notify_all();
+}
+
+void Companion::Thread::StreamEngine::RemoveFinished()
+{
+	std::vector<std::shared_ptr<EngineStream>> finished;
+	std::vector<std::shared_ptr<EngineStream>>::iterator it;
+
+	{
+		std::lock_guard<std::mutex> lk(this->mx);
+
+		it = std::stable_partition(this->streams.begin(), this->streams.end(), [](const std::shared_ptr<EngineStream>& stream)
+		{
+			return !stream->finished.load();
+		});
+		finished.assign(it, this->streams.end());
+		this->streams.erase(it, this->streams.end());
+	}
+
+	// Producers signal the engine before they return, so they are joined without lock
+	for (std::shared_ptr<EngineStream>& stream : finished)
+	{
+		if (stream->producer.joinable())
+		{
+			stream->producer.join();
+		}
+	}
+}
+
+std::shared_ptr<Companion::Thread::StreamEngine::EngineStream> Companion::Thread::StreamEngine::FindStream(int id) const
+{
+	std::lock_guard<std::mutex> lk(this->mx);
+
+	for (const std::shared_ptr<EngineStream>& stream : this->streams)
+	{
+		if (stream->id == id)
+		{
+			return stream;
+		}
+	}
+
+	throw Error::Code::stream_not_found;
+}
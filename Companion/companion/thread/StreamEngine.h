@@ -0,0 +1,248 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_STREAMENGINE_H
+#define COMPANION_STREAMENGINE_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+#include <companion/Configuration.h>
+#include <companion/thread/StreamWorker.h>
+#include <companion/util/CompanionError.h>
+#include <companion/util/Definitions.h>
+
+namespace Companion {
+	namespace Thread
+	{
+		/**
+		 * Stream engine to process many streams with one shared pool of processing threads. Each stream only owns a
+		 * producer thread to obtain its frames, the stored frames of all streams are processed by the shared threads
+		 * in round robin order so that every stream gets its turn. Results are delivered in frame order to the
+		 * callbacks of the stream's configuration.
+		 * @author Andreas Sekulski, Dimitri Kotlovsky
+		 */
+		class COMP_EXPORTS StreamEngine
+		{
+
+		public:
+
+			/**
+			 * Create a stream engine and start its processing threads.
+			 * @param processingThreads Number of shared processing threads. If processingThreads <= 0 the number of
+			 * hardware threads will be used.
+			 */
+			explicit StreamEngine(int processingThreads = 0);
+
+			/**
+			 * Discards all stored frames and waits until all threads have returned.
+			 */
+			virtual ~StreamEngine();
+
+			/**
+			 * Add a stream and start obtaining its frames. Stream source, image processing, callbacks and buffer
+			 * settings are taken from the given configuration. The number of consumer threads of the configuration
+			 * limits how many frames of this stream are processed at the same time, one by default so that the image
+			 * processing of a stream is never executed concurrently.
+			 * @param configuration Configuration of the stream, which must not be running itself.
+			 * @throws Companion::Error::Code error code if an invalid configuration is set.
+			 * @return Identifier of the added stream.
+			 */
+			int AddStream(PTR_COMPANION configuration);
+
+			/**
+			 * Stop a stream. Returns immediately, the stream is removed after its stored frames are handled.
+			 * @param id Identifier of the stream to stop.
+			 * @param mode Shutdown mode to drain or to discard the stored frames.
+			 * @throws Companion::Error::Code error code if the stream is not registered.
+			 */
+			void Stop(int id, ShutdownMode mode = ShutdownMode::DRAIN);
+
+			/**
+			 * Stop all streams. Returns immediately, use Wait() to wait for the shutdown.
+			 * @param mode Shutdown mode to drain or to discard the stored frames.
+			 */
+			void Stop(ShutdownMode mode = ShutdownMode::DRAIN);
+
+			/**
+			 * Wait until all added streams have finished or were stopped and their stored frames are handled.
+			 * Must not be called from a callback of a stream of this engine.
+			 */
+			void Wait();
+
+			/**
+			 * Get current frame statistics of a stream.
+			 * @param id Identifier of the stream.
+			 * @throws Companion::Error::Code error code if the stream is not registered.
+			 * @return Frame statistics of the stream.
+			 */
+			StreamStatistics Statistics(int id) const;
+
+			/**
+			 * Get number of streams which are not finished yet.
+			 * @return Number of running streams.
+			 */
+			int Streams() const;
+
+			/**
+			 * Get number of shared processing threads.
+			 * @return Number of processing threads.
+			 */
+			int ProcessingThreads() const;
+
+		private:
+
+			/**
+			 * Stream which is scheduled by this engine.
+			 */
+			struct EngineStream
+			{
+				/**
+				 * Identifier of this stream.
+				 */
+				int id;
+
+				/**
+				 * Stream worker which stores the frames of this stream.
+				 */
+				PTR_STREAM_WORKER worker;
+
+				/**
+				 * Image processing of this stream.
+				 */
+				PTR_IMAGE_PROCESSING processing;
+
+				/**
+				 * Error callback of this stream.
+				 */
+				std::function<ERROR_CALLBACK> errorCallback;
+
+				/**
+				 * Result callback of this stream.
+				 */
+				std::function<SUCCESS_CALLBACK> successCallback;
+
+				/**
+				 * Maximum number of frames of this stream which are processed at the same time.
+				 */
+				int maxInFlight;
+
+				/**
+				 * Number of processing threads which currently work on this stream.
+				 */
+				std::atomic<int> inFlight;
+
+				/**
+				 * Indicator if the buffer is closed and all stored frames are handled.
+				 */
+				std::atomic<bool> finished;
+
+				/**
+				 * Producer thread of this stream.
+				 */
+				std::thread producer;
+			};
+
+			/**
+			 * Registered streams.
+			 */
+			std::vector<std::shared_ptr<EngineStream>> streams;
+
+			/**
+			 * Shared processing threads.
+			 */
+			std::vector<std::thread> threads;
+
+			/**
+			 * Mutex to lock the registered streams and the thread signals.
+			 */
+			mutable std::mutex mx;
+
+			/**
+			 * Condition to wake up processing threads if frames were stored.
+			 */
+			std::condition_variable storedCv;
+
+			/**
+			 * Condition to wake up waiting callers if a stream has finished.
+			 */
+			std::condition_variable finishedCv;
+
+			/**
+			 * Number of pending wake ups for the processing threads, limited to the number of threads.
+			 */
+			int signals;
+
+			/**
+			 * Position of the stream which gets the next turn.
+			 */
+			size_t cursor;
+
+			/**
+			 * Identifier of the next added stream.
+			 */
+			int nextId;
+
+			/**
+			 * Indicator if the processing threads should return.
+			 */
+			bool terminate;
+
+			/**
+			 * Processing thread loop.
+			 */
+			void Process();
+
+			/**
+			 * Process the next stored frame in round robin order.
+			 * @return <code>True</code> if a frame was processed, <code>false</code> if no stream has a frame to process.
+			 */
+			bool ProcessNext();
+
+			/**
+			 * Wake up a processing thread because a frame was stored or a buffer was closed.
+			 */
+			void Signal();
+
+			/**
+			 * Mark a stream as finished if its buffer is closed and all frames are handled.
+			 * @param stream Stream to check.
+			 */
+			void CheckFinished(std::shared_ptr<EngineStream> stream);
+
+			/**
+			 * Remove all finished streams and join their producer threads.
+			 */
+			void RemoveFinished();
+
+			/**
+			 * Get a registered stream.
+			 * @param id Identifier of the stream.
+			 * @throws Companion::Error::Code error code if the stream is not registered.
+			 * @return Registered stream.
+			 */
+			std::shared_ptr<EngineStream> FindStream(int id) const;
+		};
+	}
+}
+
+#endif //COMPANION_STREAMENGINE_H
@@ -0,0 +1,140 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StreamHandle.h"
+
+Companion::Thread::StreamHandle::StreamHandle(PTR_STREAM_WORKER worker,
+	PTR_STREAM stream,
+	PTR_IMAGE_PROCESSING processing,
+	int skipFrame,
+	int consumerThreads,
+	std::function<ERROR_CALLBACK> errorCallback,
+	std::function<SUCCESS_CALLBACK> successCallback)
+{
+	this->worker = worker;
+	this->activeThreads = std::make_shared<std::atomic<int>>(consumerThreads + 1);
+	this->statisticsPromise = std::make_shared<std::promise<StreamStatistics>>();
+	this->statistics = this->statisticsPromise->get_future().share();
+
+	// Threads are started after all shared states are created
+	this->threads.push_back(StartThread([worker, stream, skipFrame, errorCallback]()
+	{
+		worker->Produce(stream, skipFrame, errorCallback);
+	}));
+
+	for (int i = 0; i < consumerThreads; i++)
+	{
+		this->threads.push_back(StartThread([worker, processing, errorCallback, successCallback]()
+		{
+			worker->Consume(processing, errorCallback, successCallback);
+		}));
+	}
+}
+
+Companion::Thread::StreamHandle::~StreamHandle()
+{
+	std::lock_guard<std::mutex> lk(this->joinMx);
+	bool isOwnThread = IsOwnThread();
+
+	this->worker->Stop(ShutdownMode::DISCARD);
+
+	for (std::thread& thread : this->threads)
+	{
+		if (!thread.joinable())
+		{
+			continue;
+		}
+
+		if (isOwnThread)
+		{
+			// A thread is not able to join itself, threads only use shared states which outlive this handle
+			thread.detach();
+		}
+		else
+		{
+			thread.join();
+		}
+	}
+}
+
+void Companion::Thread::StreamHandle::Stop(ShutdownMode mode)
+{
+	this->worker->Stop(mode);
+}
+
+void Companion::Thread::StreamHandle::Wait()
+{
+	this->statistics.wait();
+
+	std::lock_guard<std::mutex> lk(this->joinMx);
+	for (std::thread& thread : this->threads)
+	{
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+	}
+}
+
+bool Companion::Thread::StreamHandle::IsRunning() const
+{
+	return this->activeThreads->load() > 0;
+}
+
+std::shared_future<Companion::Thread::StreamStatistics> Companion::Thread::StreamHandle::FinalStatistics() const
+{
+	return this->statistics;
+}
+
+Companion::Thread::StreamStatistics Companion::Thread::StreamHandle::Statistics() const
+{
+	return this->worker->Statistics();
+}
+
+std::thread Companion::Thread::StreamHandle::StartThread(std::function<void()> work)
+{
+	PTR_STREAM_WORKER worker = this->worker;
+	std::shared_ptr<std::atomic<int>> activeThreads = this->activeThreads;
+	std::shared_ptr<std::promise<StreamStatistics>> statisticsPromise = this->statisticsPromise;
+
+	return std::thread([work, worker, activeThreads, statisticsPromise]()
+	{
+		work();
+
+		if (--(*activeThreads) == 0)
+		{
+			// Last returning thread, statistics are final
+			statisticsPromise->set_value(worker->Statistics());
+		}
+	});
+}
+
+bool Companion::Thread::StreamHandle::IsOwnThread() const
+{
+	std::thread::id id = std::this_thread::get_id();
+
+	for (const std::thread& thread : this->threads)
+	{
+		if (thread.get_id() == id)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,147 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_STREAMHANDLE_H
+#define COMPANION_STREAMHANDLE_H
+
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <companion/thread/StreamWorker.h>
+#include <companion/input/Stream.h>
+#include <companion/processing/ImageProcessing.h>
+#include <companion/util/Definitions.h>
+
+namespace Companion {
+	namespace Thread
+	{
+		/**
+		 * Handle of an asynchronously running stream worker. The producer and consumer threads are started on
+		 * creation, the handle is used to stop them, to wait for them or to obtain the final frame statistics.
+		 * @author Andreas Sekulski, Dimitri Kotlovsky
+		 */
+		class COMP_EXPORTS StreamHandle
+		{
+
+		public:
+
+			/**
+			 * Start a producer and the given number of consumer threads of a stream worker.
+			 * @param worker Stream worker to run.
+			 * @param stream Stream source to obtain images from.
+			 * @param processing Processing algorithm.
+			 * @param skipFrame Skipping frame rate if set.
+			 * @param consumerThreads Number of consumer threads.
+			 * @param errorCallback Error callback handler.
+			 * @param successCallback Callback handler to return results.
+			 */
+			StreamHandle(PTR_STREAM_WORKER worker,
+				PTR_STREAM stream,
+				PTR_IMAGE_PROCESSING processing,
+				int skipFrame,
+				int consumerThreads,
+				std::function<ERROR_CALLBACK> errorCallback,
+				std::function<SUCCESS_CALLBACK> successCallback);
+
+			/**
+			 * Discards all stored frames and waits until all threads have returned. If the handle is destroyed from
+			 * one of its own threads, for example in a callback, the threads are detached instead.
+			 */
+			virtual ~StreamHandle();
+
+			/**
+			 * Stop the stream worker. Returns immediately, use Wait() or the statistics future to wait for the shutdown.
+			 * @param mode Shutdown mode to drain or to discard the stored frames.
+			 */
+			void Stop(ShutdownMode mode = ShutdownMode::DRAIN);
+
+			/**
+			 * Wait until the stream has finished or the worker was stopped and all threads have returned.
+			 * Must not be called from the result or error callback of this handle.
+			 */
+			void Wait();
+
+			/**
+			 * Indicator if producer or consumers are still running.
+			 * @return True if at least one thread is running otherwise false.
+			 */
+			bool IsRunning() const;
+
+			/**
+			 * Get future of the final frame statistics which is ready when all threads have returned.
+			 * @return Shared future of the final frame statistics.
+			 */
+			std::shared_future<StreamStatistics> FinalStatistics() const;
+
+			/**
+			 * Get current frame statistics.
+			 * @return Frame statistics of the running or finished worker.
+			 */
+			StreamStatistics Statistics() const;
+
+		private:
+
+			/**
+			 * Stream worker which is executed.
+			 */
+			PTR_STREAM_WORKER worker;
+
+			/**
+			 * Number of threads which have not returned yet, shared with the threads.
+			 */
+			std::shared_ptr<std::atomic<int>> activeThreads;
+
+			/**
+			 * Promise of the final statistics which is fulfilled by the last returning thread.
+			 */
+			std::shared_ptr<std::promise<StreamStatistics>> statisticsPromise;
+
+			/**
+			 * Future of the final statistics.
+			 */
+			std::shared_future<StreamStatistics> statistics;
+
+			/**
+			 * Producer and consumer threads.
+			 */
+			std::vector<std::thread> threads;
+
+			/**
+			 * Mutex to join the threads only once.
+			 */
+			std::mutex joinMx;
+
+			/**
+			 * Run a worker method and fulfill the statistics promise if it is the last returning thread.
+			 * @param work Worker method to run.
+			 */
+			std::thread StartThread(std::function<void()> work);
+
+			/**
+			 * Indicator if the calling thread is one of the threads of this handle.
+			 * @return True if this method is called from a producer or consumer thread.
+			 */
+			bool IsOwnThread() const;
+		};
+	}
+}
+
+#endif //COMPANION_STREAMHANDLE_H
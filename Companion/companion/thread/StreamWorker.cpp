@@ -18,127 +18,425 @@
 
 #include "StreamWorker.h"
 
-Companion::Thread::StreamWorker::StreamWorker(int buffer, ColorFormat colorFormat)
+Companion::Thread::StreamWorker::StreamWorker(int buffer,
+	ColorFormat colorFormat,
+	WaitPolicy waitPolicy,
+	BackpressurePolicy backpressure) : queue(buffer, waitPolicy)
 {
-	this->finished = false;
+	this->backpressure = backpressure;
+	this->droppedFrames = 0;
+	this->storedFrames = 0;
+	this->processedFrames = 0;
+	this->failedFrames = 0;
+	this->discardedFrames = 0;
+	this->stopped = false;
+	this->discard = false;
+	this->latencyBudget = 0;
+	this->processingTime = 0.0;
+	this->frameInterval = 0.0;
+	this->consumers = 0;
+	this->storeIndex = 0;
+	this->delivering = false;
+	this->deliveryIndex = 0;
 	this->colorFormat = colorFormat;
-	this->buffer = buffer;
-	if (this->buffer <= 0)
-	{
-		this->buffer = 1;
-	}
 }
 
 void Companion::Thread::StreamWorker::Produce(PTR_STREAM stream, int skipFrame, std::function<ERROR_CALLBACK> errorCallback)
 {
 
 	int skipFrameNr = 0;
+	int currentSkipFrame = skipFrame;
 	cv::Mat frame;
+	std::chrono::steady_clock::time_point lastFrameTime;
+	std::chrono::steady_clock::time_point frameTime;
+	std::chrono::steady_clock::time_point storeTime;
+	std::chrono::steady_clock::duration blockedTime = std::chrono::steady_clock::duration::zero();
+	bool isFirstFrame = true;
 
 	try
 	{
 		frame = stream->ObtainImage();
 
-		while (!stream->IsFinished())
+		while (!stream->IsFinished() && !this->stopped)
 		{
 
 			if (!frame.empty())
 			{
-				// If skip frame is not used...
-				if (skipFrame <= 0 && StoreFrame(frame))
-				{
-					// Obtain next frame to store
-					frame = stream->ObtainImage();
-				}
-				else if (skipFrame > 0)
+				if (this->latencyBudget > 0)
 				{
-					// ... check if skip frame number is reached and If frame was stored
-					if (skipFrameNr == skipFrame && StoreFrame(frame))
+					// Measure source frame rate to adapt the skip frame rate, time parked in StoreFrame is not part of the source interval
+					frameTime = std::chrono::steady_clock::now();
+					if (!isFirstFrame)
 					{
-						// Obtain next frame to store
-						frame = stream->ObtainImage();
-						skipFrameNr = 0;
+						UpdateAverage(this->frameInterval, std::chrono::duration<double>(frameTime - lastFrameTime - blockedTime).count());
 					}
-					else if (skipFrameNr != skipFrame)
+					lastFrameTime = frameTime;
+					blockedTime = std::chrono::steady_clock::duration::zero();
+					isFirstFrame = false;
+					currentSkipFrame = AdaptiveSkipFrame(skipFrame);
+				}
+
+				// Store frame if skip frame is not used or if skip frame number is reached
+				if (skipFrameNr >= currentSkipFrame)
+				{
+					// Producer is parked until the frame could be stored
+					storeTime = std::chrono::steady_clock::now();
+					if (!StoreFrame(frame))
 					{
-						frame.release();
-						frame = stream->ObtainImage();
-						skipFrameNr++;
+						// Queue was closed
+						break;
 					}
+					blockedTime = std::chrono::steady_clock::now() - storeTime;
+					skipFrameNr = 0;
+				}
+				else
+				{
+					skipFrameNr++;
 				}
-			}
-			else
-			{
-				// If frames are empty loop
-				frame = stream->ObtainImage();
-			}
-		}
 
-		std::lock_guard<std::mutex> lk(this->mx);
-		this->finished = true;
-		this->cv.notify_all();
+				frame.release();
+			}
 
+			// Obtain next frame to store
+			frame = stream->ObtainImage();
+		}
 	}
 	catch (Error::Code error)
 	{
 		errorCallback(error);
 	}
+
+	// Release all consumers after the last frame
+	this->queue.Close();
+	NotifyStored();
 }
 
 void Companion::Thread::StreamWorker::Consume(PTR_IMAGE_PROCESSING processing, std::function<ERROR_CALLBACK> errorCallback, std::function<SUCCESS_CALLBACK> successCallback)
 {
 
-	cv::Mat frame;
+	StreamFrame frame;
+
+	this->consumers++;
+
+	while (true)
+	{
+
+		if (!this->queue.Pop(frame))
+		{
+			// Stream has finished and all stored frames are consumed
+			break;
+		}
+
+		ProcessFrame(frame, processing, errorCallback, successCallback);
+	}
+
+	// Throughput of the remaining consumers is lower
+	this->consumers--;
+}
+
+bool Companion::Thread::StreamWorker::TryConsume(PTR_IMAGE_PROCESSING processing, std::function<ERROR_CALLBACK> errorCallback, std::function<SUCCESS_CALLBACK> successCallback)
+{
+
+	StreamFrame frame;
+
+	if (!this->queue.TryPop(frame))
+	{
+		return false;
+	}
+
+	ProcessFrame(frame, processing, errorCallback, successCallback);
+	return true;
+}
+
+void Companion::Thread::StreamWorker::ProcessFrame(StreamFrame& frame, PTR_IMAGE_PROCESSING processing, std::function<ERROR_CALLBACK> errorCallback, std::function<SUCCESS_CALLBACK> successCallback)
+{
+
 	cv::Mat resultBGR;
+	CALLBACK_RESULT results;
+	std::chrono::steady_clock::time_point startTime;
 
-	while (!this->finished)
+	if (this->discard)
 	{
+		// Worker was stopped, frames which are not processed yet are not delivered anymore
+		frame.image.release();
+		this->discardedFrames++;
 
-		std::unique_lock<std::mutex> lk(this->mx);
-		this->cv.wait(lk, [this] {return this->finished || !this->queue.empty(); });
+		// Discarded frame is skipped by the ordered delivery, frames in flight are still delivered
+		Deliver(frame.index, CALLBACK_RESULT(), cv::Mat(), successCallback);
+		return;
+	}
 
-		if (!this->queue.empty())
+	try
+	{
+		if (this->framePool != nullptr && this->colorFormat != ColorFormat::BGR)
 		{
-			try
-			{
-				frame = this->queue.front();
-				this->queue.pop();
-				Util::ConvertColor(frame, resultBGR, this->colorFormat);
-				successCallback(processing->Execute(frame), resultBGR);
-			}
-			catch (Error::Code errorCode)
-			{
-				// Single error messages from processing
-				errorCallback(errorCode);
-			}
-			catch (Error::CompanionException ex)
-			{
-				// Multiple error messages only called by parallelized methods
-				while (ex.HasNext())
-				{
-					errorCallback(ex.Next());
-				}
-			}
+			// Convert image into a recycled buffer which is released after the result callback
+			resultBGR = this->framePool->Obtain(frame.image.size(), Util::ColorFormatType(frame.image.depth(), this->colorFormat));
+		}
+		Util::ConvertColor(frame.image, resultBGR, this->colorFormat);
+		startTime = std::chrono::steady_clock::now();
+		results = processing->Execute(frame.image);
+		UpdateAverage(this->processingTime, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+		this->processedFrames++;
+	}
+	catch (Error::Code errorCode)
+	{
+		// Single error messages from processing
+		errorCallback(errorCode);
+		resultBGR.release();
+		this->failedFrames++;
+	}
+	catch (Error::CompanionException ex)
+	{
+		// Multiple error messages only called by parallelized methods
+		while (ex.HasNext())
+		{
+			errorCallback(ex.Next());
+		}
+		resultBGR.release();
+		this->failedFrames++;
+	}
+
+	Deliver(frame.index, results, resultBGR, successCallback);
 
-			frame.release();
-			resultBGR.release();
+	results.clear();
+	frame.image.release();
+	resultBGR.release();
+}
+
+void Companion::Thread::StreamWorker::Deliver(unsigned long index, CALLBACK_RESULT results, cv::Mat image, std::function<SUCCESS_CALLBACK> successCallback)
+{
+	std::map<unsigned long, std::pair<CALLBACK_RESULT, cv::Mat>>::iterator it;
+	std::pair<CALLBACK_RESULT, cv::Mat> result;
+	std::unique_lock<std::mutex> lk(this->deliveryMx);
+
+	this->pendingResults[index] = std::make_pair(results, image);
+	if (this->delivering)
+	{
+		// Another consumer is delivering results and will deliver this one too if it's next
+		return;
+	}
+
+	this->delivering = true;
+	it = this->pendingResults.find(this->deliveryIndex);
+	while (it != this->pendingResults.end())
+	{
+		result = it->second;
+		this->pendingResults.erase(it);
+		this->deliveryIndex++;
+
+		// Call handler without lock so other consumers are able to store their results
+		lk.unlock();
+		if (!result.second.empty())
+		{
+			successCallback(result.first, result.second);
 		}
+		result.first.clear();
+		result.second.release();
+		lk.lock();
+
+		it = this->pendingResults.find(this->deliveryIndex);
+	}
+	this->delivering = false;
+}
+
+void Companion::Thread::StreamWorker::Stop(ShutdownMode mode)
+{
+
+	if (mode == ShutdownMode::DISCARD)
+	{
+		this->discard = true;
+	}
+
+	// Producer returns before obtaining the next frame, a parked producer is released by closing the queue
+	this->stopped = true;
+	this->queue.Close();
+	NotifyStored();
+}
+
+bool Companion::Thread::StreamWorker::IsClosed() const
+{
+	return this->queue.IsClosed();
+}
+
+size_t Companion::Thread::StreamWorker::BufferedFrames() const
+{
+	return this->queue.Size();
+}
+
+void Companion::Thread::StreamWorker::StoreCallback(std::function<void()> storeCallback)
+{
+	this->storeCallback = storeCallback;
+}
+
+void Companion::Thread::StreamWorker::Consumers(int consumers)
+{
+
+	if (consumers < 0)
+	{
+		consumers = 0;
+	}
+
+	this->consumers = consumers;
+}
+
+void Companion::Thread::StreamWorker::NotifyStored()
+{
+
+	if (this->storeCallback)
+	{
+		this->storeCallback();
+	}
+}
+
+bool Companion::Thread::StreamWorker::IsStopped() const
+{
+	return this->stopped.load();
+}
+
+unsigned long Companion::Thread::StreamWorker::DroppedFrames() const
+{
+	return this->droppedFrames.load();
+}
+
+Companion::Thread::StreamStatistics Companion::Thread::StreamWorker::Statistics() const
+{
+	StreamStatistics statistics;
+
+	statistics.storedFrames = this->storedFrames.load();
+	statistics.processedFrames = this->processedFrames.load();
+	statistics.failedFrames = this->failedFrames.load();
+	statistics.droppedFrames = this->droppedFrames.load();
+	statistics.discardedFrames = this->discardedFrames.load();
+
+	return statistics;
+}
+
+int Companion::Thread::StreamWorker::LatencyBudget() const
+{
+	return this->latencyBudget;
+}
+
+void Companion::Thread::StreamWorker::LatencyBudget(int latencyBudget)
+{
+
+	if (latencyBudget <= 0)
+	{
+		latencyBudget = 0;
+	}
+
+	this->latencyBudget = latencyBudget;
+}
+
+void Companion::Thread::StreamWorker::FramePool(PTR_FRAME_POOL framePool)
+{
+	this->framePool = framePool;
+}
+
+int Companion::Thread::StreamWorker::AdaptiveSkipFrame(int skipFrame)
+{
+	std::lock_guard<std::mutex> lk(this->statisticsMx);
+	double throughput;
+	double latency;
+	double adaptiveSkipFrame;
+
+	if (this->processingTime <= 0.0 || this->frameInterval <= 0.0)
+	{
+		// No measurements yet
+		return skipFrame;
+	}
+
+	// Number of frames per second all consumers are able to process
+	throughput = std::max(1, this->consumers.load()) / this->processingTime;
+
+	// Skip so many frames that the remaining source frame rate matches the throughput
+	adaptiveSkipFrame = std::ceil(1.0 / (this->frameInterval * throughput)) - 1.0;
+
+	// Expected latency of the next stored frame from waiting in the queue and its own processing
+	latency = (this->queue.Size() / throughput) + this->processingTime;
+	if (latency * 1000.0 > this->latencyBudget)
+	{
+		// Queue has to be reduced to keep the latency budget
+		adaptiveSkipFrame += 1.0;
+	}
+
+	return std::max(skipFrame, static_cast<int>(std::min(adaptiveSkipFrame, static_cast<double>(MAX_ADAPTIVE_SKIP_FRAME))));
+}
+
+void Companion::Thread::StreamWorker::UpdateAverage(double& average, double value)
+{
+	std::lock_guard<std::mutex> lk(this->statisticsMx);
+
+	if (average <= 0.0)
+	{
+		average = value;
+	}
+	else
+	{
+		// Exponential moving average so that only recent measurements are considered
+		average = (1.0 - AVERAGE_WEIGHT) * average + AVERAGE_WEIGHT * value;
 	}
 }
 
 bool Companion::Thread::StreamWorker::StoreFrame(cv::Mat frame)
 {
-	std::lock_guard<std::mutex> lk(this->mx);
-	if (this->queue.size() >= this->buffer)
+	StreamFrame streamFrame = { this->storeIndex, frame };
+
+	if (this->queue.IsClosed())
 	{
-		// If buffer full try to notify producer and wait current frame and do nothing
-		this->cv.notify_one();
 		return false;
 	}
-	else
+
+	switch (this->backpressure)
+	{
+	case BackpressurePolicy::BLOCK:
+		// Producer is parked until the frame could be stored
+		if (!this->queue.Push(streamFrame))
+		{
+			return false;
+		}
+		break;
+	case BackpressurePolicy::DROP_NEWEST:
+		if (!this->queue.TryPush(streamFrame))
+		{
+			// Drop this frame, index is not used
+			this->droppedFrames++;
+			return true;
+		}
+		break;
+	case BackpressurePolicy::LATEST_ONLY:
+		// Drop all waiting frames so that this frame is the next to process
+		while (DropOldestFrame()) {}
+		// Store frame like DROP_OLDEST
+		// fall through
+	case BackpressurePolicy::DROP_OLDEST:
+		while (!this->queue.TryPush(streamFrame))
+		{
+			DropOldestFrame();
+		}
+		break;
+	}
+
+	this->storeIndex++;
+	this->storedFrames++;
+	NotifyStored();
+	return true;
+}
+
+bool Companion::Thread::StreamWorker::DropOldestFrame()
+{
+	StreamFrame frame;
+
+	if (!this->queue.TryPop(frame))
 	{
-		this->queue.push(frame);
-		this->cv.notify_one();
-		return true;
+		return false;
 	}
+
+	frame.image.release();
+	this->droppedFrames++;
+
+	// Dropped frame is skipped by the ordered delivery
+	std::lock_guard<std::mutex> lk(this->deliveryMx);
+	this->pendingResults[frame.index] = std::make_pair(CALLBACK_RESULT(), cv::Mat());
+	return true;
 }
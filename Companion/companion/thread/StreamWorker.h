@@ -19,10 +19,15 @@
 #ifndef COMPANION_STREAMWORKER_H
 #define COMPANION_STREAMWORKER_H
 
-#include <queue>
+#include <map>
+#include <cmath>
 #include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <functional>
 #include <opencv2/core/core.hpp>
+#include <companion/thread/RingBuffer.h>
 #include <companion/processing/ImageProcessing.h>
 #include <companion/draw/Drawable.h>
 #include <companion/input/Stream.h>
@@ -35,7 +40,59 @@ namespace Companion {
 	namespace Thread
 	{
 		/**
-		 * Stream worker class to produce and consume images from a streaming source.
+		 * Backpressure policies if the image buffer of a stream worker is full.
+		 */
+		enum class BackpressurePolicy
+		{
+			BLOCK, ///< Producer waits until the buffer has free space, no frames are dropped.
+			DROP_NEWEST, ///< The new frame is dropped and the producer obtains the next frame.
+			DROP_OLDEST, ///< The oldest stored frame is dropped to store the new frame.
+			LATEST_ONLY ///< All stored frames are dropped so that only the latest frame waits for processing.
+		};
+
+		/**
+		 * Shutdown modes of a stream worker which is stopped before its stream has finished.
+		 */
+		enum class ShutdownMode
+		{
+			DRAIN, ///< No new frames are obtained, all stored frames are processed and delivered.
+			DISCARD ///< No new frames are obtained, stored frames which are not processed yet are discarded.
+		};
+
+		/**
+		 * Frame statistics of a stream worker.
+		 */
+		struct StreamStatistics
+		{
+			/**
+			 * Number of frames which were stored to the image buffer.
+			 */
+			unsigned long storedFrames;
+
+			/**
+			 * Number of frames which were processed and delivered to the result callback.
+			 */
+			unsigned long processedFrames;
+
+			/**
+			 * Number of frames whose processing raised an error.
+			 */
+			unsigned long failedFrames;
+
+			/**
+			 * Number of frames which were dropped by the backpressure policy.
+			 */
+			unsigned long droppedFrames;
+
+			/**
+			 * Number of stored frames which were discarded by a shutdown.
+			 */
+			unsigned long discardedFrames;
+		};
+
+		/**
+		 * Stream worker class to produce and consume images from a streaming source. Multiple consumers can process
+		 * images in parallel, results are nevertheless returned in the order of the frames.
 		 * @author Andreas Sekulski, Dimitri Kotlovsky
 		 */
 		class COMP_EXPORTS StreamWorker
@@ -43,12 +100,33 @@ namespace Companion {
 
 		public:
 
+			/**
+			 * Frame obtained from a stream together with its position in the stream.
+			 */
+			struct StreamFrame
+			{
+				/**
+				 * Position of this frame in the sequence of stored frames.
+				 */
+				unsigned long index;
+
+				/**
+				 * Image data of this frame.
+				 */
+				cv::Mat image;
+			};
+
 			/**
 			 * Create a stream worker to obtain images from a stream and store to a queue.
 			 * @param buffer Buffer size to store images. Default is one image.
 			 * @param colorFormat Color format of the returned image.
+			 * @param waitPolicy Wait policy for producer and consumers if the buffer is full or empty.
+			 * @param backpressure Policy to handle new frames if the buffer is full.
 			 */
-			StreamWorker(int buffer = 1, ColorFormat colorFormat = ColorFormat::BGR);
+			StreamWorker(int buffer = 1,
+				ColorFormat colorFormat = ColorFormat::BGR,
+				WaitPolicy waitPolicy = WaitPolicy::BLOCKING,
+				BackpressurePolicy backpressure = BackpressurePolicy::BLOCK);
 
 			/**
 			 * Produce stream data and store to the queue.
@@ -59,24 +137,107 @@ namespace Companion {
 			void Produce(PTR_STREAM stream, int skipFrame, std::function<ERROR_CALLBACK> errorCallback);
 
 			/**
-			 * Consume stream data from stored queue and process it.
+			 * Consume stream data from stored queue and process it. This method can be executed by multiple threads at
+			 * the same time, the given image processing must be safe to be executed concurrently in this case.
 			 * @param processing Processing algorithm.
 			 * @param errorCallback Error callback handler.
 			 * @param successCallback Callback handler to return results.
 			 */
 			void Consume(PTR_IMAGE_PROCESSING processing, std::function<ERROR_CALLBACK> errorCallback, std::function<SUCCESS_CALLBACK> successCallback);
 
+			/**
+			 * Process the next stored frame if one is available without waiting. Used by an external scheduler which
+			 * distributes the frames of several workers onto shared threads.
+			 * @param processing Processing algorithm.
+			 * @param errorCallback Error callback handler.
+			 * @param successCallback Callback handler to return results.
+			 * @return <code>True</code> if a frame was consumed, <code>false</code> if no frame is stored.
+			 */
+			bool TryConsume(PTR_IMAGE_PROCESSING processing, std::function<ERROR_CALLBACK> errorCallback, std::function<SUCCESS_CALLBACK> successCallback);
+
+			/**
+			 * Set a callback which is called by the producer after a frame was stored and after the image buffer was
+			 * closed. Must be set before producing frames.
+			 * @param storeCallback Callback to notify an external scheduler.
+			 */
+			void StoreCallback(std::function<void()> storeCallback);
+
+			/**
+			 * Set number of threads which process frames of this worker through TryConsume() at the same time. Used to
+			 * estimate the throughput for adaptive frame skipping, consumers of Consume() are counted by themselves.
+			 * @param consumers Number of consumers. If consumers < 0 the number of consumers is 0.
+			 */
+			void Consumers(int consumers);
+
+			/**
+			 * Indicator if the image buffer was closed because the stream has finished or the worker was stopped.
+			 * @return True if no further frames are stored otherwise false.
+			 */
+			bool IsClosed() const;
+
+			/**
+			 * Get number of frames which are stored and wait for processing.
+			 * @return Number of stored frames.
+			 */
+			size_t BufferedFrames() const;
+
+			/**
+			 * Stop producing frames before the stream has finished. Producer and consumers return after the stored
+			 * frames are handled by the given shutdown mode. Can be called from any thread, also from callbacks.
+			 * @param mode Shutdown mode to drain or to discard the stored frames.
+			 */
+			void Stop(ShutdownMode mode = ShutdownMode::DRAIN);
+
+			/**
+			 * Indicator if this worker was stopped.
+			 * @return True if Stop() was called otherwise false.
+			 */
+			bool IsStopped() const;
+
+			/**
+			 * Get number of frames which were dropped by the backpressure policy.
+			 * @return Number of dropped frames.
+			 */
+			unsigned long DroppedFrames() const;
+
+			/**
+			 * Get current frame statistics of this worker.
+			 * @return Frame statistics, final if producer and all consumers have returned.
+			 */
+			StreamStatistics Statistics() const;
+
+			/**
+			 * Get latency budget for adaptive frame skipping.
+			 * @return Latency budget in milliseconds, 0 if adaptive frame skipping is not used.
+			 */
+			int LatencyBudget() const;
+
+			/**
+			 * Set latency budget for adaptive frame skipping. The skip frame rate is adapted from the measured processing
+			 * time and source frame rate so that stored frames are processed within this budget. Must be set before
+			 * producing frames.
+			 * @param latencyBudget Latency budget in milliseconds. If latencyBudget <= 0 adaptive frame skipping is not used.
+			 */
+			void LatencyBudget(int latencyBudget);
+
+			/**
+			 * Set a frame pool to obtain buffers for the converted images of the result callback. Must be set before
+			 * consuming frames.
+			 * @param framePool Frame pool to use or nullptr to allocate new images.
+			 */
+			void FramePool(PTR_FRAME_POOL framePool);
+
 		private:
 
 			/**
-			 * Indicator to cancel threads.
+			 * Weight of a new measurement for the moving averages of processing time and frame interval.
 			 */
-			bool finished;
+			static constexpr double AVERAGE_WEIGHT = 0.2;
 
 			/**
-			 * Buffer size for storing images.
+			 * Maximum number of frames which are skipped by adaptive frame skipping.
 			 */
-			int buffer;
+			static constexpr int MAX_ADAPTIVE_SKIP_FRAME = 1000;
 
 			/**
 			 * Color format of the returned image.
@@ -84,26 +245,161 @@ namespace Companion {
 			ColorFormat colorFormat;
 
 			/**
-			 * Mutex to lock the thread.
+			 * Ring buffer to store images from stream.
+			 */
+			RingBuffer<StreamFrame> queue;
+
+			/**
+			 * Policy to handle new frames if the buffer is full.
+			 */
+			BackpressurePolicy backpressure;
+
+			/**
+			 * Number of frames which were dropped by the backpressure policy.
+			 */
+			std::atomic<unsigned long> droppedFrames;
+
+			/**
+			 * Number of frames which were stored to the queue.
+			 */
+			std::atomic<unsigned long> storedFrames;
+
+			/**
+			 * Number of frames which were processed and delivered.
+			 */
+			std::atomic<unsigned long> processedFrames;
+
+			/**
+			 * Number of frames whose processing raised an error.
+			 */
+			std::atomic<unsigned long> failedFrames;
+
+			/**
+			 * Number of stored frames which were discarded by a shutdown.
+			 */
+			std::atomic<unsigned long> discardedFrames;
+
+			/**
+			 * Indicator if this worker was stopped.
+			 */
+			std::atomic<bool> stopped;
+
+			/**
+			 * Indicator if stored frames should be discarded instead of processed.
+			 */
+			std::atomic<bool> discard;
+
+			/**
+			 * Callback to notify an external scheduler about stored frames.
+			 */
+			std::function<void()> storeCallback;
+
+			/**
+			 * Frame pool to obtain buffers for converted images.
+			 */
+			PTR_FRAME_POOL framePool;
+
+			/**
+			 * Latency budget for adaptive frame skipping in milliseconds, 0 if not used.
+			 */
+			int latencyBudget;
+
+			/**
+			 * Moving average of the image processing time in seconds.
+			 */
+			double processingTime;
+
+			/**
+			 * Moving average of the time between two source frames in seconds.
 			 */
-			std::mutex mx;
+			double frameInterval;
 
 			/**
-			 * Condition to wait.
+			 * Mutex to lock the measurements for adaptive frame skipping.
 			 */
-			std::condition_variable cv;
+			std::mutex statisticsMx;
 
 			/**
-			 * Queue to store images from stream.
+			 * Number of consumers which process frames, running Consume() calls or the number set by an external scheduler.
 			 */
-			std::queue<cv::Mat> queue;
+			std::atomic<int> consumers;
 
 			/**
-			 * Store a frame to queue.
+			 * Index of the next frame which will be stored to the queue.
+			 */
+			unsigned long storeIndex;
+
+			/**
+			 * Mutex to lock the ordered result delivery.
+			 */
+			std::mutex deliveryMx;
+
+			/**
+			 * Indicator if a consumer is currently delivering results.
+			 */
+			bool delivering;
+
+			/**
+			 * Index of the next frame whose result should be delivered.
+			 */
+			unsigned long deliveryIndex;
+
+			/**
+			 * Processed frames which are waiting for the delivery of their predecessors. Frames without a result
+			 * (for example if an error occurred) are stored with an empty image.
+			 */
+			std::map<unsigned long, std::pair<CALLBACK_RESULT, cv::Mat>> pendingResults;
+
+			/**
+			 * Process a frame which was taken from the queue and deliver its result.
+			 * @param frame Frame to process.
+			 * @param processing Processing algorithm.
+			 * @param errorCallback Error callback handler.
+			 * @param successCallback Callback handler to return results.
+			 */
+			void ProcessFrame(StreamFrame& frame, PTR_IMAGE_PROCESSING processing, std::function<ERROR_CALLBACK> errorCallback, std::function<SUCCESS_CALLBACK> successCallback);
+
+			/**
+			 * Call the store callback if set.
+			 */
+			void NotifyStored();
+
+			/**
+			 * Store a frame to queue. If the queue is full the backpressure policy decides whether to wait or to drop frames.
 			 * @param frame Frame to store to queue.
-			 * @return <code>True</code> if the frame was stored, <code>flase</code> otherwise.
+			 * @return <code>True</code> if the producer can continue, <code>false</code> if the queue was closed.
 			 */
 			bool StoreFrame(cv::Mat frame);
+
+			/**
+			 * Calculate the skip frame rate from the measured processing time and source frame rate.
+			 * @param skipFrame Minimum skip frame rate.
+			 * @return Skip frame rate to keep the latency budget.
+			 */
+			int AdaptiveSkipFrame(int skipFrame);
+
+			/**
+			 * Add a measurement to a moving average.
+			 * @param average Moving average to update.
+			 * @param value Measured value.
+			 */
+			void UpdateAverage(double& average, double value);
+
+			/**
+			 * Drop the oldest stored frame and mark it as skipped for the ordered result delivery.
+			 * @return <code>True</code> if a frame was dropped, <code>false</code> if the queue is empty.
+			 */
+			bool DropOldestFrame();
+
+			/**
+			 * Deliver the result of the given frame in frame order. If predecessors of the frame are still processed
+			 * the result is stored and delivered by the consumer which finishes the last predecessor.
+			 * @param index Index of the processed frame.
+			 * @param results Results of the image processing.
+			 * @param image Converted image of the frame, an empty image if the frame should not be delivered.
+			 * @param successCallback Callback handler to return results.
+			 */
+			void Deliver(unsigned long index, CALLBACK_RESULT results, cv::Mat image, std::function<SUCCESS_CALLBACK> successCallback);
 		};
 	}
 }
@@ -0,0 +1,236 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TaskPool.h"
+
+Companion::Thread::TaskPool::TaskPool(int threads)
+{
+	this->pendingTasks = 0;
+	this->nextQueue = 0;
+	this->terminate = false;
+
+	if (threads <= 0)
+	{
+		threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	// Calling thread of a parallel loop is the last thread
+	for (int i = 0; i < threads - 1; i++)
+	{
+		this->queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+	}
+
+	for (size_t i = 0; i < this->queues.size(); i++)
+	{
+		this->workers.push_back(std::thread(&TaskPool::Work, this, i));
+	}
+}
+
+Companion::Thread::TaskPool::~TaskPool()
+{
+
+	{
+		std::lock_guard<std::mutex> lk(this->sleepMx);
+		this->terminate = true;
+	}
+	this->sleepCv.notify_all();
+
+	for (std::thread& worker : this->workers)
+	{
+		worker.join();
+	}
+}
+
+void Companion::Thread::TaskPool::ParallelFor(int count, std::function<void(int)> task)
+{
+	std::shared_ptr<Batch> batch;
+	Task nextTask;
+	size_t queue;
+
+	if (count <= 0)
+	{
+		return;
+	}
+
+	batch = std::make_shared<Batch>();
+	batch->task = task;
+	batch->remaining = count;
+
+	if (count == 1 || this->queues.empty())
+	{
+		// Nothing to parallelize, execute all tasks in the calling thread
+		for (int i = 0; i < count; i++)
+		{
+			nextTask = { batch, i };
+			Execute(nextTask);
+		}
+	}
+	else
+	{
+		// Distribute tasks over all queues, the first queue changes with each loop to spread small loops
+		queue = this->nextQueue++;
+		for (int i = 0; i < count; i++)
+		{
+			TaskQueue& taskQueue = *this->queues[(queue + i) % this->queues.size()];
+			std::lock_guard<std::mutex> lk(taskQueue.mx);
+			taskQueue.tasks.push_back({ batch, i });
+		}
+
+		{
+			std::lock_guard<std::mutex> lk(this->sleepMx);
+			this->pendingTasks += count;
+		}
+		this->sleepCv.notify_all();
+
+		// Calling thread helps until all tasks of this loop are taken
+		while (batch->remaining > 0 && TakeTask(queue, nextTask))
+		{
+			Execute(nextTask);
+		}
+
+		// Remaining tasks are executed by worker threads
+		std::unique_lock<std::mutex> lk(batch->mx);
+		batch->finishedCv.wait(lk, [&batch]()
+		{
+			return batch->remaining == 0;
+		});
+	}
+
+	if (batch->exception)
+	{
+		std::rethrow_exception(batch->exception);
+	}
+
+	if (!batch->errors.empty())
+	{
+		throw Error::CompanionException(batch->errors);
+	}
+}
+
+int Companion::Thread::TaskPool::Threads() const
+{
+	return static_cast<int>(this->workers.size()) + 1;
+}
+
+PTR_TASK_POOL Companion::Thread::TaskPool::Default()
+{
+	static PTR_TASK_POOL taskPool = std::make_shared<TASK_POOL>();
+	return taskPool;
+}
+
+void Companion::Thread::TaskPool::Work(size_t queue)
+{
+	Task task;
+
+	while (true)
+	{
+
+		if (TakeTask(queue, task))
+		{
+			Execute(task);
+			continue;
+		}
+
+		// Park until new tasks are queued
+		std::unique_lock<std::mutex> lk(this->sleepMx);
+		this->sleepCv.wait(lk, [this]()
+		{
+			return this->terminate || this->pendingTasks > 0;
+		});
+
+		if (this->terminate)
+		{
+			break;
+		}
+	}
+}
+
+bool Companion::Thread::TaskPool::TakeTask(size_t queue, Task& task)
+{
+
+	for (size_t i = 0; i < this->queues.size(); i++)
+	{
+		TaskQueue& taskQueue = *this->queues[(queue + i) % this->queues.size()];
+		std::lock_guard<std::mutex> lk(taskQueue.mx);
+
+		if (taskQueue.tasks.empty())
+		{
+			continue;
+		}
+
+		if (i == 0)
+		{
+			// Own queue, newest task first
+			task = taskQueue.tasks.back();
+			taskQueue.tasks.pop_back();
+		}
+		else
+		{
+			// Steal oldest task of another queue
+			task = taskQueue.tasks.front();
+			taskQueue.tasks.pop_front();
+		}
+
+		this->pendingTasks--;
+		return true;
+	}
+
+	return false;
+}
+
+void Companion::Thread::TaskPool::Execute(Task& task)
+{
+	std::shared_ptr<Batch> batch = task.batch;
+
+	try
+	{
+		batch->task(task.index);
+	}
+	catch (Error::Code errorCode)
+	{
+		std::lock_guard<std::mutex> lk(batch->mx);
+		batch->errors.push_back(errorCode);
+	}
+	catch (const Error::CompanionException& ex)
+	{
+		// Reading the errors advances the exception, so a copy is read
+		Error::CompanionException nested = ex;
+		std::lock_guard<std::mutex> lk(batch->mx);
+		while (nested.HasNext())
+		{
+			batch->errors.push_back(nested.Next());
+		}
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lk(batch->mx);
+		if (!batch->exception)
+		{
+			batch->exception = std::current_exception();
+		}
+	}
+
+	// Release reference before the calling thread is woken up
+	task.batch = nullptr;
+
+	if (--batch->remaining == 0)
+	{
+		std::lock_guard<std::mutex> lk(batch->mx);
+		batch->finishedCv.notify_all();
+	}
+}
@@ -0,0 +1,212 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_TASKPOOL_H
+#define COMPANION_TASKPOOL_H
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+#include <companion/util/CompanionError.h>
+#include <companion/util/CompanionException.h>
+#include <companion/util/Definitions.h>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion {
+	namespace Thread
+	{
+		/**
+		 * Persistent work stealing task pool. Each worker thread owns a task queue and steals tasks from the queues of
+		 * other workers if its own queue is empty. Threads are created once, so parallel loops do not pay a thread
+		 * team start per call. The calling thread of a parallel loop executes tasks too, so parallel loops can be
+		 * nested or called from several threads at the same time without blocking the pool.
+		 * @author Andreas Sekulski, Dimitri Kotlovsky
+		 */
+		class COMP_EXPORTS TaskPool
+		{
+
+		public:
+
+			/**
+			 * Create a task pool.
+			 * @param threads Number of threads which execute tasks, including the calling thread of a parallel loop.
+			 * If threads <= 0 the number of hardware threads will be used.
+			 */
+			explicit TaskPool(int threads = 0);
+
+			/**
+			 * Waits until all worker threads have returned, tasks must not be running anymore.
+			 */
+			virtual ~TaskPool();
+
+			/**
+			 * Execute a task for each index in [0, count) in parallel and wait until all tasks are finished.
+			 * @param count Number of tasks.
+			 * @param task Task to execute with its index. Must be safe to be executed concurrently.
+			 * @throws Companion::Error::CompanionException if tasks raised Companion::Error::Code errors, all error codes
+			 * are collected. Other exceptions of tasks are rethrown after all tasks are finished.
+			 */
+			void ParallelFor(int count, std::function<void(int)> task);
+
+			/**
+			 * Get number of threads which execute tasks, including the calling thread.
+			 * @return Number of threads.
+			 */
+			int Threads() const;
+
+			/**
+			 * Get shared task pool of the library which uses all hardware threads.
+			 * @return Shared task pool.
+			 */
+			static PTR_TASK_POOL Default();
+
+		private:
+
+			/**
+			 * Tasks of a single parallel loop.
+			 */
+			struct Batch
+			{
+				/**
+				 * Task to execute for each index.
+				 */
+				std::function<void(int)> task;
+
+				/**
+				 * Number of tasks which are not finished yet.
+				 */
+				std::atomic<int> remaining;
+
+				/**
+				 * Mutex to lock the collected errors and the finish condition.
+				 */
+				std::mutex mx;
+
+				/**
+				 * Condition to wake up the calling thread if all tasks are finished.
+				 */
+				std::condition_variable finishedCv;
+
+				/**
+				 * Collected error codes of all tasks.
+				 */
+				std::vector<Error::Code> errors;
+
+				/**
+				 * First exception of a task which is not an error code.
+				 */
+				std::exception_ptr exception;
+			};
+
+			/**
+			 * Single task of a parallel loop.
+			 */
+			struct Task
+			{
+				/**
+				 * Parallel loop of this task.
+				 */
+				std::shared_ptr<Batch> batch;
+
+				/**
+				 * Index of this task.
+				 */
+				int index;
+			};
+
+			/**
+			 * Task queue of a worker thread.
+			 */
+			struct TaskQueue
+			{
+				/**
+				 * Mutex to lock the tasks.
+				 */
+				std::mutex mx;
+
+				/**
+				 * Tasks, the owner takes tasks from the back and other threads steal from the front.
+				 */
+				std::deque<Task> tasks;
+			};
+
+			/**
+			 * Task queues, one for each worker thread.
+			 */
+			std::vector<std::unique_ptr<TaskQueue>> queues;
+
+			/**
+			 * Worker threads.
+			 */
+			std::vector<std::thread> workers;
+
+			/**
+			 * Number of queued tasks which are not taken yet.
+			 */
+			std::atomic<int> pendingTasks;
+
+			/**
+			 * Queue which gets the first task of the next parallel loop.
+			 */
+			std::atomic<unsigned int> nextQueue;
+
+			/**
+			 * Mutex to park idle worker threads.
+			 */
+			std::mutex sleepMx;
+
+			/**
+			 * Condition to wake up idle worker threads.
+			 */
+			std::condition_variable sleepCv;
+
+			/**
+			 * Indicator if the worker threads should return.
+			 */
+			bool terminate;
+
+			/**
+			 * Worker thread loop.
+			 * @param queue Index of the own task queue.
+			 */
+			void Work(size_t queue);
+
+			/**
+			 * Take a task, first from the given queue and then from the other queues.
+			 * @param queue Index of the queue to take from first.
+			 * @param task Taken task.
+			 * @return <code>True</code> if a task was taken, <code>false</code> if all queues are empty.
+			 */
+			bool TakeTask(size_t queue, Task& task);
+
+			/**
+			 * Execute a task and collect its errors.
+			 * @param task Task to execute.
+			 */
+			void Execute(Task& task);
+		};
+	}
+}
+
+#endif //COMPANION_TASKPOOL_H
@@ -42,6 +42,8 @@ namespace Companion { namespace Error
         no_image_processing_algo_set, ///< If no image processing algo is used.
         no_handler_set, ///< If no callback handler is set.
         no_cuda_device, ///< If no CUDA device is ready to use.
+        stream_not_found, ///< If given stream is not registered.
+        invalid_feature_cache, ///< If a feature cache file could not be written.
         not_implemented ///< If method is not implemented.
     };
 
@@ -95,6 +97,12 @@ namespace Companion { namespace Error
             case Code::no_cuda_device:
                 error = "No CUDA device can be used.";
                 break;
+            case Code::stream_not_found:
+                error = "Stream is not registered.";
+                break;
+            case Code::invalid_feature_cache:
+                error = "Feature cache could not be written.";
+                break;
             case Code ::not_implemented:
                 error = "Method not implemented.";
                 break;
@@ -39,6 +39,15 @@ namespace Companion
 	#define STREAM_WORKER Companion::Thread::StreamWorker
 	#define PTR_STREAM_WORKER std::shared_ptr<STREAM_WORKER>
 
+	#define STREAM_HANDLE Companion::Thread::StreamHandle
+	#define PTR_STREAM_HANDLE std::shared_ptr<STREAM_HANDLE>
+
+	#define STREAM_ENGINE Companion::Thread::StreamEngine
+	#define PTR_STREAM_ENGINE std::shared_ptr<STREAM_ENGINE>
+
+	#define TASK_POOL Companion::Thread::TaskPool
+	#define PTR_TASK_POOL std::shared_ptr<TASK_POOL>
+
 	// Stream module definitions
 	#define STREAM Companion::Input::Stream
 	#define PTR_STREAM std::shared_ptr<STREAM>
@@ -49,6 +58,9 @@ namespace Companion
 	#define IMAGE_STREAM Companion::Input::Image
 	#define PTR_IMAGE_STREAM std::shared_ptr<IMAGE_STREAM>
 
+	#define FRAME_POOL Companion::Input::FramePool
+	#define PTR_FRAME_POOL std::shared_ptr<FRAME_POOL>
+
 	// Image processing definitions
 	#define IMAGE_PROCESSING Companion::Processing::ImageProcessing
 	#define PTR_IMAGE_PROCESSING std::shared_ptr<IMAGE_PROCESSING>
@@ -69,6 +81,18 @@ namespace Companion
 	#define IMAGE_REDUCTION_ALGORITHM Companion::Algorithm::Recognition::Matching::IRA
 	#define PTR_IMAGE_REDUCTION_ALGORITHM std::shared_ptr<IMAGE_REDUCTION_ALGORITHM>
 
+	#define OBJECT_TRACK Companion::Algorithm::Recognition::Matching::ObjectTrack
+	#define PTR_OBJECT_TRACK std::shared_ptr<OBJECT_TRACK>
+
+	#define TRACKING_STATE Companion::Algorithm::Recognition::Matching::TrackingState
+	#define PTR_TRACKING_STATE std::shared_ptr<TRACKING_STATE>
+
+	#define TRACKING_CONTEXT Companion::Algorithm::Recognition::Matching::TrackingContext
+	#define PTR_TRACKING_CONTEXT std::shared_ptr<TRACKING_CONTEXT>
+
+	#define DESCRIPTOR_INDEX Companion::Algorithm::Recognition::Matching::DescriptorIndex
+	#define PTR_DESCRIPTOR_INDEX std::shared_ptr<DESCRIPTOR_INDEX>
+
 	#define FEATURE_MATCHING Companion::Algorithm::Recognition::Matching::FeatureMatching
 	#define PTR_FEATURE_MATCHING std::shared_ptr<FEATURE_MATCHING>
 
@@ -85,6 +109,12 @@ namespace Companion
 	#define MODEL_IMAGE_HASHING Companion::Model::Processing::ImageHashModel
 	#define PTR_MODEL_IMAGE_HASHING std::shared_ptr<MODEL_IMAGE_HASHING>
 
+	#define HASH_INDEX Companion::Model::Processing::HashIndex
+	#define PTR_HASH_INDEX std::shared_ptr<HASH_INDEX>
+
+	#define FEATURE_CACHE Companion::Model::Processing::FeatureCache
+	#define PTR_FEATURE_CACHE std::shared_ptr<FEATURE_CACHE>
+
 	// Draw model definitions
 	#define DRAW Companion::Draw::Drawable
 	#define PTR_DRAW std::shared_ptr<DRAW>
@@ -119,6 +149,11 @@ namespace Companion
        * Default error callback function declaration to obtain error results from companion.
        */
     #define ERROR_CALLBACK void(Companion::Error::Code)
+
+      /**
+       * Progress callback function declaration with the number of finished and the number of all operations.
+       */
+    #define PROGRESS_CALLBACK void(int, int)
 }
 
 #endif //COMPANION_DEFINITIONS_H
@@ -0,0 +1,220 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ScalingPolicy.h"
+
+Companion::ScalingPolicy::ScalingPolicy()
+{
+	this->size = cv::Size();
+	this->maxDimension = 0;
+	this->scaleFactor = 1.0;
+	this->keepAspect = true;
+	this->upscale = false;
+	this->interpolation = AUTO_INTERPOLATION;
+}
+
+Companion::ScalingPolicy::ScalingPolicy(SCALING scaling) : ScalingPolicy(ScalingSize(scaling), true)
+{
+}
+
+Companion::ScalingPolicy::ScalingPolicy(cv::Size size, bool keepAspect) : ScalingPolicy()
+{
+	this->size = size;
+	this->keepAspect = keepAspect;
+}
+
+Companion::ScalingPolicy Companion::ScalingPolicy::MaxDimension(int maxDimension)
+{
+	ScalingPolicy policy;
+	policy.maxDimension = std::max(maxDimension, 0);
+	return policy;
+}
+
+Companion::ScalingPolicy Companion::ScalingPolicy::Factor(double scaleFactor)
+{
+	ScalingPolicy policy;
+
+	if (scaleFactor > 0.0)
+	{
+		policy.scaleFactor = scaleFactor;
+	}
+
+	return policy;
+}
+
+cv::Size Companion::ScalingPolicy::TargetSize(const cv::Size& imageSize) const
+{
+	double scaleX = this->scaleFactor;
+	double scaleY = this->scaleFactor;
+	double scale;
+
+	if (imageSize.width <= 0 || imageSize.height <= 0)
+	{
+		return imageSize;
+	}
+
+	if (this->size.width > 0 && this->size.height > 0)
+	{
+		scaleX = static_cast<double>(this->size.width) / imageSize.width;
+		scaleY = static_cast<double>(this->size.height) / imageSize.height;
+
+		if (this->keepAspect)
+		{
+			// Fit image into the size, the smaller scale is used for both sides
+			scale = std::min(scaleX, scaleY);
+			scaleX = scale;
+			scaleY = scale;
+		}
+	}
+	else if (this->maxDimension > 0)
+	{
+		scaleX = static_cast<double>(this->maxDimension) / std::max(imageSize.width, imageSize.height);
+		scaleY = scaleX;
+	}
+
+	if (!this->upscale)
+	{
+		scaleX = std::min(scaleX, 1.0);
+		scaleY = std::min(scaleY, 1.0);
+	}
+
+	return cv::Size(std::max(1, static_cast<int>(std::lround(imageSize.width * scaleX))),
+		std::max(1, static_cast<int>(std::lround(imageSize.height * scaleY))));
+}
+
+bool Companion::ScalingPolicy::Resize(cv::Mat& img) const
+{
+	cv::Size targetSize;
+	int flag = this->interpolation;
+
+	if (img.empty())
+	{
+		return false;
+	}
+
+	targetSize = TargetSize(img.size());
+	if (targetSize == img.size())
+	{
+		// Image has its target size already, no copy is needed
+		return false;
+	}
+
+	if (flag == AUTO_INTERPOLATION)
+	{
+		flag = (targetSize.area() < img.size().area()) ? cv::INTER_AREA : cv::INTER_LINEAR;
+	}
+
+	cv::resize(img, img, targetSize, 0, 0, flag);
+	return true;
+}
+
+bool Companion::ScalingPolicy::KeepAspect() const
+{
+	return this->keepAspect;
+}
+
+void Companion::ScalingPolicy::KeepAspect(bool keepAspect)
+{
+	this->keepAspect = keepAspect;
+}
+
+bool Companion::ScalingPolicy::Upscale() const
+{
+	return this->upscale;
+}
+
+void Companion::ScalingPolicy::Upscale(bool upscale)
+{
+	this->upscale = upscale;
+}
+
+int Companion::ScalingPolicy::Interpolation() const
+{
+	return this->interpolation;
+}
+
+void Companion::ScalingPolicy::Interpolation(int interpolation)
+{
+	this->interpolation = interpolation;
+}
+
+cv::Size Companion::ScalingPolicy::ScalingSize(SCALING scaling)
+{
+	cv::Size size;
+	switch (scaling)
+	{
+	case Companion::SCALING::SCALE_2048x1152:
+		size.width = 2048;
+		size.height = 1152;
+		break;
+	case Companion::SCALING::SCALE_1920x1080:
+		size.width = 1920;
+		size.height = 1080;
+		break;
+	case Companion::SCALING::SCALE_1600x900:
+		size.width = 1600;
+		size.height = 900;
+		break;
+	case Companion::SCALING::SCALE_1408x792:
+		size.width = 1408;
+		size.height = 792;
+		break;
+	case Companion::SCALING::SCALE_1344x756:
+		size.width = 1344;
+		size.height = 756;
+		break;
+	case Companion::SCALING::SCALE_1280x720:
+		size.width = 1280;
+		size.height = 720;
+		break;
+	case Companion::SCALING::SCALE_1152x648:
+		size.width = 1152;
+		size.height = 648;
+		break;
+	case Companion::SCALING::SCALE_1024x576:
+		size.width = 1024;
+		size.height = 576;
+		break;
+	case Companion::SCALING::SCALE_960x540:
+		size.width = 960;
+		size.height = 540;
+		break;
+	case Companion::SCALING::SCALE_896x504:
+		size.width = 896;
+		size.height = 504;
+		break;
+	case Companion::SCALING::SCALE_800x450:
+		size.width = 800;
+		size.height = 450;
+		break;
+	case Companion::SCALING::SCALE_768x432:
+		size.width = 768;
+		size.height = 432;
+		break;
+	case Companion::SCALING::SCALE_640x360:
+		size.width = 640;
+		size.height = 360;
+		break;
+	case Companion::SCALING::SCALE_320x180:
+		size.width = 320;
+		size.height = 180;
+		break;
+	}
+
+	return size;
+}
@@ -0,0 +1,176 @@
+/*
+ * This program is an image recognition library written with OpenCV.
+ * Copyright (C) 2016-2018 Andreas Sekulski, Dimitri Kotlovsky
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPANION_SCALINGPOLICY_H
+#define COMPANION_SCALINGPOLICY_H
+
+#include <algorithm>
+#include <cmath>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <companion/util/Util.h>
+#include <companion/util/exportapi/ExportAPIDefinitions.h>
+
+namespace Companion
+{
+	/**
+	 * Scaling policy which calculates the size of a resized image from the size of the source image. An image is
+	 * resized to fit into a maximum size, to a maximum dimension or with a scale factor. By default the aspect ratio
+	 * is kept and images are never upscaled, images which already have their target size are not copied.
+	 * @author Andreas Sekulski, Dimitri Kotlovsky
+	 */
+	class COMP_EXPORTS ScalingPolicy
+	{
+
+	public:
+
+		/**
+		 * Interpolation which uses area interpolation to shrink and linear interpolation to enlarge images.
+		 */
+		static constexpr int AUTO_INTERPOLATION = -1;
+
+		/**
+		 * Create a scaling policy which keeps images as they are.
+		 */
+		ScalingPolicy();
+
+		/**
+		 * Create a scaling policy from a scaling resolution. Images are fit into the resolution with their aspect
+		 * ratio kept and are not upscaled.
+		 * @param scaling Scaling resolution which is the maximum size of images.
+		 */
+		ScalingPolicy(SCALING scaling);
+
+		/**
+		 * Create a scaling policy which fits images into the given size.
+		 * @param size Maximum width and height in pixels.
+		 * @param keepAspect Keep the aspect ratio, otherwise images are resized to the given size.
+		 */
+		ScalingPolicy(cv::Size size, bool keepAspect = true);
+
+		/**
+		 * Destructor.
+		 */
+		virtual ~ScalingPolicy() = default;
+
+		/**
+		 * Create a scaling policy which resizes images so that their larger side has the given length.
+		 * @param maxDimension Length of the larger image side in pixels.
+		 * @return Scaling policy with the given maximum dimension.
+		 */
+		static ScalingPolicy MaxDimension(int maxDimension);
+
+		/**
+		 * Create a scaling policy which resizes images with the given scale factor.
+		 * @param scaleFactor Scale factor for width and height, for example 0.5 to halve images.
+		 * @return Scaling policy with the given scale factor.
+		 */
+		static ScalingPolicy Factor(double scaleFactor);
+
+		/**
+		 * Calculate the size of a resized image.
+		 * @param imageSize Size of the source image.
+		 * @return Size of the resized image, imageSize if the image is not resized.
+		 */
+		cv::Size TargetSize(const cv::Size& imageSize) const;
+
+		/**
+		 * Resize given image with this policy. The image is not changed if it already has its target size.
+		 * @param img Image to resize.
+		 * @return <code>True</code> if the image is resized, <code>false</code> otherwise.
+		 */
+		bool Resize(cv::Mat& img) const;
+
+		/**
+		 * Indicator if the aspect ratio of images is kept.
+		 * @return True if the aspect ratio is kept otherwise false.
+		 */
+		bool KeepAspect() const;
+
+		/**
+		 * Set to keep the aspect ratio of images, only used if images are fit into a maximum size.
+		 * @param keepAspect Keep the aspect ratio.
+		 */
+		void KeepAspect(bool keepAspect);
+
+		/**
+		 * Indicator if images can be upscaled.
+		 * @return True if images can be upscaled otherwise false.
+		 */
+		bool Upscale() const;
+
+		/**
+		 * Set to allow or prevent upscaling of images.
+		 * @param upscale Allow to enlarge images.
+		 */
+		void Upscale(bool upscale);
+
+		/**
+		 * Get interpolation which is used to resize images.
+		 * @return OpenCV interpolation flag or AUTO_INTERPOLATION.
+		 */
+		int Interpolation() const;
+
+		/**
+		 * Set interpolation which is used to resize images.
+		 * @param interpolation OpenCV interpolation flag like cv::INTER_LINEAR or AUTO_INTERPOLATION.
+		 */
+		void Interpolation(int interpolation);
+
+	private:
+
+		/**
+		 * Maximum width and height of images, not used if empty.
+		 */
+		cv::Size size;
+
+		/**
+		 * Maximum length of the larger image side, not used if zero.
+		 */
+		int maxDimension;
+
+		/**
+		 * Scale factor of images, used if neither size nor maximum dimension are set.
+		 */
+		double scaleFactor;
+
+		/**
+		 * Indicator to keep the aspect ratio.
+		 */
+		bool keepAspect;
+
+		/**
+		 * Indicator to allow upscaling.
+		 */
+		bool upscale;
+
+		/**
+		 * OpenCV interpolation flag or AUTO_INTERPOLATION.
+		 */
+		int interpolation;
+
+		/**
+		 * Get scaling from given enumeration as size.
+		 * @param scaling Scaling to obtain size.
+		 * @return Width and height of the scaling resolution in pixels.
+		 */
+		static cv::Size ScalingSize(SCALING scaling);
+	};
+}
+
+#endif //COMPANION_SCALINGPOLICY_H
@@ -17,6 +17,7 @@
  */
 
 #include "Util.h"
+#include "ScalingPolicy.h"
 
 cv::Mat Companion::Util::CutImage(cv::Mat img, cv::Rect cutArea)
 {
@@ -30,8 +31,7 @@ bool Companion::Util::IsImageLoaded(const cv::Mat& img)
 
 void Companion::Util::ResizeImage(cv::Mat& img, SCALING scaling)
 {
-	cv::Point size = Scaling(scaling);
-	cv::resize(img, img, cv::Size(size.x, size.y), cv::INTER_AREA);
+	ScalingPolicy(scaling).Resize(img);
 }
 
 void Companion::Util::ResizeImage(cv::Mat& img, cv::Size size)
@@ -95,68 +95,24 @@ void Companion::Util::ConvertColor(cv::Mat& src, cv::Mat& dst, Companion::ColorF
 	}
 }
 
-cv::Point Companion::Util::Scaling(SCALING scaling)
+int Companion::Util::ColorFormatType(int depth, Companion::ColorFormat colorFormat)
 {
-	cv::Point size;
-	switch (scaling)
+	int channels = 3;
+
+	switch (colorFormat)
 	{
-	case Companion::SCALING::SCALE_2048x1152:
-		size.x = 2048;
-		size.y = 1152;
-		break;
-	case Companion::SCALING::SCALE_1920x1080:
-		size.x = 1920;
-		size.y = 1080;
-		break;
-	case Companion::SCALING::SCALE_1600x900:
-		size.x = 1600;
-		size.y = 900;
-		break;
-	case Companion::SCALING::SCALE_1408x792:
-		size.x = 1408;
-		size.y = 792;
-		break;
-	case Companion::SCALING::SCALE_1344x756:
-		size.x = 1344;
-		size.y = 756;
-		break;
-	case Companion::SCALING::SCALE_1280x720:
-		size.x = 1280;
-		size.y = 720;
-		break;
-	case Companion::SCALING::SCALE_1152x648:
-		size.x = 1152;
-		size.y = 648;
-		break;
-	case Companion::SCALING::SCALE_1024x576:
-		size.x = 1024;
-		size.y = 576;
-		break;
-	case Companion::SCALING::SCALE_960x540:
-		size.x = 960;
-		size.y = 540;
-		break;
-	case Companion::SCALING::SCALE_896x504:
-		size.x = 896;
-		size.y = 504;
-		break;
-	case Companion::SCALING::SCALE_800x450:
-		size.x = 800;
-		size.y = 450;
-		break;
-	case Companion::SCALING::SCALE_768x432:
-		size.x = 768;
-		size.y = 432;
+	case Companion::ColorFormat::RGB:
+	case Companion::ColorFormat::BGR:
+		channels = 3;
 		break;
-	case Companion::SCALING::SCALE_640x360:
-		size.x = 640;
-		size.y = 360;
+	case Companion::ColorFormat::RGBA:
+	case Companion::ColorFormat::BGRA:
+		channels = 4;
 		break;
-	case Companion::SCALING::SCALE_320x180:
-		size.x = 320;
-		size.y = 180;
+	case Companion::ColorFormat::GRAY:
+		channels = 1;
 		break;
 	}
 
-	return size;
+	return CV_MAKETYPE(depth, channels);
 }
@@ -21,8 +21,12 @@
 #define COMPANION_UTIL_H
 
 #include <iostream>
+#include <cstdint>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#if !defined(__GNUC__) && !defined(__clang__)
+#include <bitset>
+#endif
 #include <companion/model/result/Result.h>
 #include <companion/util/exportapi/ExportAPIDefinitions.h>
 
@@ -86,9 +90,9 @@ namespace Companion
 		static bool IsImageLoaded(const cv::Mat& img);
 
 		/**
-		 * Resize given image.
+		 * Resize given image to fit into the given scaling resolution, see ScalingPolicy.
 		 * @param img Image to resize.
-		 * @param scaling Scaling factor to resize.
+		 * @param scaling Scaling resolution which is the maximum size of the image.
 		 */
 		static void ResizeImage(cv::Mat& img, SCALING scaling);
 
@@ -137,14 +141,22 @@ namespace Companion
 		 */
 		static void ConvertColor(cv::Mat& src, cv::Mat& dst, ColorFormat colorFormat);
 
-	private:
+		/**
+		 * Get the OpenCV image type of an image in the given color format.
+		 * @param depth Depth of the image, for example CV_8U.
+		 * @param colorFormat Color format of the image.
+		 * @return OpenCV image type, for example CV_8UC3.
+		 */
+		static int ColorFormatType(int depth, ColorFormat colorFormat);
 
 		/**
-		 * Get scaling from given enumeration as point representation.
-		 * @param scaling Scaling to obtain point.
-		 * @return Scaling as point representation where x is the width and y the height in pixels.
+		 * Count the set bits of a 64 bit word, used for Hamming distances of binary descriptors and hashes.
+		 * @param value Word to count.
+		 * @return Number of set bits.
 		 */
-		static cv::Point Scaling(SCALING scaling);
+		static int PopCount(uint64_t value);
+
+	private:
 
 		/**
 		 * Calculate the deviation between two lengths.
@@ -156,4 +168,14 @@ namespace Companion
 	};
 }
 
+// Defined inline because it is called in the inner loops of distance calculations
+inline int Companion::Util::PopCount(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(value);
+#else
+	return static_cast<int>(std::bitset<64>(value).count());
+#endif
+}
+
 #endif //COMPANION_UTIL_H